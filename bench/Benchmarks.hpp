@@ -0,0 +1,45 @@
+#ifndef SESAMO_BENCH_BENCHMARKS_HPP
+#define SESAMO_BENCH_BENCHMARKS_HPP
+
+#include <span>
+#include <string_view>
+
+namespace bench
+{
+
+// Epoll vs io_uring reader: syscalls per MB and arrival latency.
+int run_backends(std::span<const std::string_view> args);
+
+// Ports on a single reactor: reactor CPU per port and per MB/s.
+int run_scaling(std::span<const std::string_view> args);
+
+// Fixed rates and chunk sizes over a pty: MB/s, write() to read_all()
+// latency, allocations and reader CPU per MB, optionally as JSON.
+int run_throughput(std::span<const std::string_view> args);
+
+// Reads shown by a paced frame loop: read to present latency histogram.
+int run_latency(std::span<const std::string_view> args);
+
+// Serial::open() and close() over and over, idle and under load.
+int run_cycle(std::span<const std::string_view> args);
+
+// A device that resets over and over: time from its node coming back to
+// the port reading again.
+int run_reconnect(std::span<const std::string_view> args);
+
+// A device writing on time while stress threads load every core: bytes
+// the tty could not take, with the reader thread pinned, SCHED_FIFO and
+// locked in memory and without.
+int run_overrun(std::span<const std::string_view> args);
+
+// A consumer that only looks every so often, under each Serial::Backpressure:
+// bytes the tty held off, delivered, dropped and spilled, holes in the
+// stream.
+int run_backpressure(std::span<const std::string_view> args);
+
+// UI ingestion of one frame with 10k to 1M reads queued: cost per read.
+int run_ingest(std::span<const std::string_view> args);
+
+} // namespace bench
+
+#endif // SESAMO_BENCH_BENCHMARKS_HPP
@@ -0,0 +1,164 @@
+#ifndef SESAMO_BENCH_COMMON_HPP
+#define SESAMO_BENCH_COMMON_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <fcntl.h>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <unistd.h>
+#include <vector>
+
+namespace bench
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Master/slave pseudo terminal pair, the slave side stands in for the serial
+// device and the benchmark plays the device by writing into the master.
+class [[nodiscard]] PtyPair final
+{
+  public:
+    static auto open() -> std::optional<PtyPair>
+    {
+        const auto master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if (master < 0) { return std::nullopt; }
+        if (grantpt(master) < 0 || unlockpt(master) < 0) {
+            ::close(master);
+            return std::nullopt;
+        }
+
+        // NOLINTNEXTLINE(concurrency-mt-unsafe)
+        return PtyPair(master, ptsname(master));
+    }
+
+    ~PtyPair()
+    {
+        if (master >= 0) { ::close(master); }
+    }
+
+    PtyPair(const PtyPair &)            = delete;
+    PtyPair &operator=(const PtyPair &) = delete;
+
+    PtyPair(PtyPair &&other) noexcept
+      : master(std::exchange(other.master, -1)),
+        slave(std::move(other.slave))
+    {}
+
+    PtyPair &operator=(PtyPair &&other) noexcept
+    {
+        std::swap(master, other.master);
+        std::swap(slave, other.slave);
+        return *this;
+    }
+
+    [[nodiscard]] int                master_fd() const { return master; }
+    [[nodiscard]] const std::string &slave_path() const { return slave; }
+
+    // Blocking write of the whole buffer into the master side.
+    bool write_all(const char *data, std::size_t size) const
+    {
+        while (size > 0) {
+            const auto written = ::write(master, data, size);
+            if (written < 0) {
+                if (errno == EINTR) { continue; }
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+  private:
+    PtyPair(int master, std::string slave)
+      : master(master),
+        slave(std::move(slave))
+    {}
+
+    int         master = -1;
+    std::string slave;
+};
+
+// Looks for `--name=value` among `args`, returns `fallback` when absent or
+// when the value does not parse.
+template <typename T>
+[[nodiscard]] T option(
+  const std::span<const std::string_view> args,
+  const std::string_view                  name,
+  const T                                 fallback
+)
+{
+    for (const auto arg : args) {
+        if (!arg.starts_with(name) || arg.size() <= name.size()
+            || arg[name.size()] != '=') {
+            continue;
+        }
+
+        const auto text = arg.substr(name.size() + 1);
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            return text;
+        } else {
+            T          value = fallback;
+            const auto [_, error] =
+              std::from_chars(text.data(), text.data() + text.size(), value);
+            if (error == std::errc{}) { return value; }
+        }
+    }
+
+    return fallback;
+}
+
+// Parses a comma separated `--name=1,2,3` value, skipping what does not
+// parse.
+[[nodiscard]] inline std::vector<std::size_t>
+  parse_list(const std::string_view text)
+{
+    std::vector<std::size_t> values;
+    for (const auto part : std::views::split(text, ',')) {
+        const auto  item  = std::string_view(part.begin(), part.end());
+        std::size_t value = 0;
+        const auto [end, error] =
+          std::from_chars(item.data(), item.data() + item.size(), value);
+        if (error == std::errc{} && end == item.data() + item.size()) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+// Returns the requested percentile (0-100) of `samples`, reorders them.
+template <typename T>
+[[nodiscard]] T percentile(std::vector<T> &samples, const double which)
+{
+    if (samples.empty()) { return T{}; }
+
+    const auto rank = static_cast<std::size_t>(
+      (which / 100.0) * static_cast<double>(samples.size() - 1)
+    );
+    std::ranges::nth_element(
+      samples, samples.begin() + static_cast<std::ptrdiff_t>(rank)
+    );
+    return samples[rank];
+}
+
+// Heap allocations made by any thread of the process so far, counted by the
+// global operator new replacement in allocations.cpp.
+[[nodiscard]] std::uint64_t allocations() noexcept;
+
+[[nodiscard]] inline double
+  to_microseconds(const std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+} // namespace bench
+
+#endif // SESAMO_BENCH_COMMON_HPP
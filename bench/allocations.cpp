@@ -0,0 +1,86 @@
+#include "Common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<std::uint64_t> count = 0;
+
+[[nodiscard]] void *allocate(const std::size_t size)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    auto *const memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) { throw std::bad_alloc(); }
+    return memory;
+}
+
+[[nodiscard]] void *
+  allocate_aligned(const std::size_t size, const std::align_val_t alignment)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    const auto align   = static_cast<std::size_t>(alignment);
+    const auto rounded = ((std::max<std::size_t>(size, 1) + align - 1) / align)
+                         * align;
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    auto *const memory = std::aligned_alloc(align, rounded);
+    if (memory == nullptr) { throw std::bad_alloc(); }
+    return memory;
+}
+
+} // namespace
+
+namespace bench
+{
+
+std::uint64_t allocations() noexcept
+{
+    return count.load(std::memory_order_relaxed);
+}
+
+} // namespace bench
+
+// Every other form of new and delete ends up in these.
+void *operator new(const std::size_t size) { return allocate(size); }
+void *operator new[](const std::size_t size) { return allocate(size); }
+
+void *operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    return allocate_aligned(size, alignment);
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t alignment)
+{
+    return allocate_aligned(size, alignment);
+}
+
+// NOLINTBEGIN(cppcoreguidelines-no-malloc)
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+void operator delete(void *memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+void operator delete[](void *memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+// NOLINTEND(cppcoreguidelines-no-malloc)
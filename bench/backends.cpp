@@ -0,0 +1,178 @@
+#include "Benchmarks.hpp"
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "Serial.hpp"
+
+#include <thread>
+#include <print>
+
+namespace
+{
+
+struct Result
+{
+    Reactor::Backend backend;
+    double           megabytes_per_second;
+    double           syscalls_per_megabyte;
+    double           wakeups_per_megabyte;
+    double           latency_p50_us;
+    double           latency_p99_us;
+    double           latency_max_us;
+    std::uint64_t    dropped;
+};
+
+[[nodiscard]] std::string_view to_string(const Reactor::Backend backend)
+{
+    switch (backend) {
+        case Reactor::Backend::Epoll: return "epoll";
+        case Reactor::Backend::IoUring: return "io_uring";
+    }
+    return "unknown";
+}
+
+// Reactor syscalls (epoll_wait/io_uring_enter) plus the port's own reads.
+[[nodiscard]] std::uint64_t
+  total_syscalls(const Reactor &reactor, const Serial &serial)
+{
+    return reactor.stats().syscalls + serial.stats().reads;
+}
+
+[[nodiscard]] auto measure(
+  const Reactor::Backend backend,
+  const std::size_t      total_bytes,
+  const std::size_t      chunk_size,
+  const std::size_t      pings
+) -> std::optional<Result>
+{
+    auto pty = bench::PtyPair::open();
+    if (!pty) { return std::nullopt; }
+
+    const auto reactor = Reactor::spawn(backend);
+    if (!reactor) { return std::nullopt; }
+
+    auto serial = Serial::open(pty->slave_path(), 115200, reactor);
+    if (!serial) { return std::nullopt; }
+    auto &port = **serial;
+
+    // Throughput: the writer pushes as fast as the pty lets it while we spin
+    // on the consumer side, so the reader is the only thing being measured.
+    const auto before         = total_syscalls(*reactor, port);
+    const auto wakeups_before = reactor->stats().wakeups;
+    const auto start          = bench::Clock::now();
+    std::thread writer([&pty, total_bytes, chunk_size] {
+        const std::vector<char> chunk(chunk_size, 'x');
+        for (std::size_t written = 0; written < total_bytes;
+             written += chunk_size) {
+            pty->write_all(
+              chunk.data(), std::min(chunk_size, total_bytes - written)
+            );
+        }
+    });
+
+    // Yield while spinning, on small machines the reader shares our core.
+    while (port.stats().received < total_bytes) {
+        if (port.read_all([](std::span<const char>) {}) == 0) {
+            std::this_thread::yield();
+        }
+    }
+    const auto elapsed = bench::Clock::now() - start;
+    writer.join();
+    const auto after         = total_syscalls(*reactor, port);
+    const auto wakeups_after = reactor->stats().wakeups;
+
+    // Latency: single byte pings, time from write() to it being visible to
+    // the consumer.
+    std::vector<std::chrono::nanoseconds> samples;
+    samples.reserve(pings);
+    for (std::size_t i = 0; i < pings; ++i) {
+        const auto sent = bench::Clock::now();
+        pty->write_all("p", 1);
+        while (port.read_all([](std::span<const char>) {}) == 0) {
+            std::this_thread::yield();
+        }
+        samples.push_back(bench::Clock::now() - sent);
+    }
+
+    const auto megabytes =
+      static_cast<double>(total_bytes) / (1024.0 * 1024.0);
+    const auto seconds  = std::chrono::duration<double>(elapsed).count();
+    const auto syscalls = static_cast<double>(after - before);
+    const auto wakeups  = static_cast<double>(wakeups_after - wakeups_before);
+
+    const auto result = Result{
+        .backend               = reactor->backend(),
+        .megabytes_per_second  = megabytes / seconds,
+        .syscalls_per_megabyte = syscalls / megabytes,
+        .wakeups_per_megabyte  = wakeups / megabytes,
+        .latency_p50_us =
+          bench::to_microseconds(bench::percentile(samples, 50)),
+        .latency_p99_us =
+          bench::to_microseconds(bench::percentile(samples, 99)),
+        .latency_max_us =
+          bench::to_microseconds(bench::percentile(samples, 100)),
+        .dropped = port.dropped_bytes(),
+    };
+
+    port.close();
+    return result;
+}
+
+} // namespace
+
+namespace bench
+{
+
+int run_backends(const std::span<const std::string_view> args)
+{
+    const auto megabytes = option<std::size_t>(args, "--megabytes", 64);
+    const auto chunk     = option<std::size_t>(args, "--chunk", 4096);
+    const auto pings     = option<std::size_t>(args, "--pings", 2000);
+
+    std::print(
+      "{:<10} {:>10} {:>12} {:>12} {:>10} {:>10} {:>10} {:>10}\n",
+      "backend",
+      "MB/s",
+      "syscalls/MB",
+      "wakeups/MB",
+      "p50 us",
+      "p99 us",
+      "max us",
+      "dropped"
+    );
+
+    for (const auto backend :
+         { Reactor::Backend::Epoll, Reactor::Backend::IoUring }) {
+        const auto result =
+          measure(backend, megabytes * 1024 * 1024, chunk, pings);
+        if (!result) {
+            std::print(stderr, "[ERROR] failed to set up pty loopback\n");
+            return 1;
+        }
+
+        if (result->backend != backend) {
+            std::print(
+              stderr,
+              "[WARNING] {} unavailable, measured {} instead\n",
+              to_string(backend),
+              to_string(result->backend)
+            );
+        }
+
+        std::print(
+          "{:<10} {:>10.1f} {:>12.1f} {:>12.1f} "
+          "{:>10.1f} {:>10.1f} {:>10.1f} {:>10}\n",
+          to_string(result->backend),
+          result->megabytes_per_second,
+          result->syscalls_per_megabyte,
+          result->wakeups_per_megabyte,
+          result->latency_p50_us,
+          result->latency_p99_us,
+          result->latency_max_us,
+          result->dropped
+        );
+    }
+
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,210 @@
+#include "Benchmarks.hpp"
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "Serial.hpp"
+
+#include <atomic>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+struct Result
+{
+    std::uint64_t offered   = 0;
+    std::uint64_t refused   = 0;
+    std::uint64_t delivered = 0;
+    std::uint64_t dropped   = 0;
+    std::uint64_t spilled   = 0;
+    std::uint64_t pauses    = 0;
+    // Places the delivered stream skips ahead of what the device sent.
+    std::uint64_t holes = 0;
+};
+
+// The device writes every tick, like a UART whose FIFO fills at the baud
+// rate no matter what the host is doing.
+constexpr auto TICK = std::chrono::milliseconds(1);
+
+// Every byte is its position in what the tty took, modulo a prime so a
+// skipped ring full still shows up as a hole.
+constexpr std::uint64_t PATTERN_PERIOD = 251;
+
+// How long the port gets to hand over what it held back or spilled once
+// the device stopped.
+constexpr auto CATCH_UP_TIMEOUT = std::chrono::seconds(10);
+
+[[nodiscard]] auto measure(
+  const Reactor::Backend          backend,
+  const Serial::Buffering        &buffering,
+  const std::size_t               rate,
+  const std::chrono::milliseconds stall,
+  const std::chrono::nanoseconds  duration
+) -> std::optional<Result>
+{
+    auto pty = bench::PtyPair::open();
+    if (!pty) { return std::nullopt; }
+    // A full tty buffer makes writes come up short instead of blocking,
+    // that is the device being held off.
+    // NOLINTNEXTLINE
+    fcntl(pty->master_fd(), F_SETFL, O_NONBLOCK);
+
+    const auto reactor = Reactor::spawn(backend);
+    if (!reactor) { return std::nullopt; }
+
+    auto serial =
+      Serial::open(pty->slave_path(), 115200, reactor, buffering);
+    if (!serial) { return std::nullopt; }
+    auto &port = **serial;
+
+    Result            result;
+    std::atomic<bool> writing = true;
+    std::thread       writer([&] {
+        const auto chunk = std::max<std::size_t>(
+          rate * static_cast<std::size_t>(TICK.count()) / 1000, 1
+        );
+        std::vector<char> bytes(chunk);
+        std::uint64_t     accepted = 0;
+        const auto        start    = bench::Clock::now();
+        for (auto due = start; due - start < duration; due += TICK) {
+            std::this_thread::sleep_until(due);
+            for (std::size_t i = 0; i < chunk; ++i) {
+                bytes[i] = static_cast<char>((accepted + i) % PATTERN_PERIOD);
+            }
+            // NOLINTNEXTLINE
+            const auto written =
+              ::write(pty->master_fd(), bytes.data(), bytes.size());
+            const auto taken =
+              written < 0 ? 0 : static_cast<std::size_t>(written);
+            result.offered += chunk;
+            result.refused += chunk - taken;
+            accepted       += taken;
+        }
+        writing.store(false, std::memory_order_release);
+    });
+
+    // A consumer that only looks every `stall`, say a minimized window.
+    std::uint64_t expected = 0;
+    const auto    consume  = [&] {
+        result.delivered += port.read_all(
+          [&](const std::span<const char> bytes) {
+              for (const auto byte : bytes) {
+                  const auto value = static_cast<unsigned char>(byte);
+                  if (value != expected) { ++result.holes; }
+                  expected = (value + 1) % PATTERN_PERIOD;
+              }
+          },
+          [](std::size_t) {}
+        );
+    };
+    while (writing.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(stall);
+        consume();
+    }
+    writer.join();
+
+    // Then everything the port still has, wherever it kept it.
+    const auto until = bench::Clock::now() + CATCH_UP_TIMEOUT;
+    do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        consume();
+    } while ((port.is_behind() || port.stats().backlog > 0)
+             && bench::Clock::now() < until);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    consume();
+
+    const auto stats = port.stats();
+    result.dropped   = port.dropped_bytes();
+    result.spilled   = stats.spilled;
+    result.pauses    = stats.pauses;
+    port.close();
+    return result;
+}
+
+} // namespace
+
+namespace bench
+{
+
+int run_backpressure(const std::span<const std::string_view> args)
+{
+    constexpr std::size_t KIBIBYTE = 1024;
+
+    const auto rate     = option<std::size_t>(args, "--rate", 4'000'000);
+    const auto seconds  = option<double>(args, "--seconds", 2.0);
+    const auto stall_ms = option<std::size_t>(args, "--stall-ms", 250);
+    const auto buffer   = option<std::size_t>(args, "--buffer-kib", 256);
+    const auto backend  = option<std::string_view>(args, "--backend", "epoll")
+                             == "io_uring"
+                           ? Reactor::Backend::IoUring
+                           : Reactor::Backend::Epoll;
+    if (rate == 0 || buffer == 0) {
+        std::print(stderr, "[ERROR] --rate and --buffer-kib must not be 0\n");
+        return 1;
+    }
+
+    std::print(
+      "{:<12} {:>10} {:>10} {:>11} {:>10} {:>10} {:>7} {:>6}\n",
+      "policy",
+      "offered B",
+      "refused %",
+      "delivered %",
+      "dropped %",
+      "spilled B",
+      "pauses",
+      "holes"
+    );
+    for (const auto policy :
+         { Serial::Backpressure::DropNewest,
+           Serial::Backpressure::DropOldest,
+           Serial::Backpressure::Block,
+           Serial::Backpressure::Spill }) {
+        Serial::Buffering buffering;
+        buffering.policy   = policy;
+        buffering.capacity = buffer * KIBIBYTE;
+
+        const auto result = measure(
+          backend,
+          buffering,
+          rate,
+          std::chrono::milliseconds(stall_ms),
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(seconds)
+          )
+        );
+        if (!result) {
+            std::print(stderr, "[ERROR] failed to set up pty loopback\n");
+            return 1;
+        }
+
+        const auto percent = [&result](const std::uint64_t bytes) {
+            return 100.0 * static_cast<double>(bytes)
+                   / static_cast<double>(std::max<std::uint64_t>(
+                     result->offered, 1
+                   ));
+        };
+        std::print(
+          "{:<12} {:>10} {:>10.3f} {:>11.3f} {:>10.3f} {:>10} {:>7} {:>6}\n",
+          Serial::describe(policy),
+          result->offered,
+          percent(result->refused),
+          percent(result->delivered),
+          percent(result->dropped),
+          result->spilled,
+          result->pauses,
+          result->holes
+        );
+    }
+    std::print(
+      "(the consumer reads every {} ms into a {} KiB buffer; refused is what "
+      "the tty held the device off for, holes where the stream skips)\n",
+      stall_ms,
+      buffer
+    );
+    return 0;
+}
+
+} // namespace bench
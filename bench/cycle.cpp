@@ -0,0 +1,179 @@
+#include "Benchmarks.hpp"
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "Serial.hpp"
+
+#include <atomic>
+#include <fcntl.h>
+#include <thread>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+struct Result
+{
+    std::size_t load;
+    std::size_t cycles;
+    double      open_p50_us;
+    double      open_p99_us;
+    double      open_max_us;
+    double      close_p50_us;
+    double      close_p99_us;
+    double      close_max_us;
+};
+
+constexpr std::size_t LOAD_CHUNK = 4096;
+
+[[nodiscard]] auto measure(
+  const Reactor::Backend backend,
+  const std::size_t      load,
+  const std::size_t      cycles
+) -> std::optional<Result>
+{
+    auto pty = bench::PtyPair::open();
+    if (!pty) { return std::nullopt; }
+
+    const auto &path = pty->slave_path();
+
+    // Keeps the pty up between cycles and, as the device side never waits
+    // for a reader, writes never block once its buffer is full.
+    // NOLINTNEXTLINE
+    const auto slave = ::open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (slave < 0) { return std::nullopt; }
+    // NOLINTNEXTLINE
+    fcntl(pty->master_fd(), F_SETFL, O_NONBLOCK);
+
+    const auto reactor = Reactor::spawn(backend);
+    if (!reactor) {
+        ::close(slave);
+        return std::nullopt;
+    }
+
+    // Floods the port at `load` bytes per second the whole time, so every
+    // close() has to get in between the reactor's reads.
+    std::atomic<bool> loading = load > 0;
+    std::thread       writer([&] {
+        const std::vector<char> bytes(LOAD_CHUNK, 'x');
+        const auto              start    = bench::Clock::now();
+        const auto              interval = std::chrono::duration<double>(
+          static_cast<double>(LOAD_CHUNK)
+          / static_cast<double>(std::max<std::size_t>(load, 1))
+        );
+        for (std::size_t i = 0; loading.load(std::memory_order_relaxed);
+             ++i) {
+            std::this_thread::sleep_until(
+              start
+              + std::chrono::duration_cast<bench::Clock::duration>(
+                interval * static_cast<double>(i)
+              )
+            );
+            // NOLINTNEXTLINE
+            [[maybe_unused]] const auto _ =
+              ::write(pty->master_fd(), bytes.data(), bytes.size());
+        }
+    });
+
+    std::vector<std::chrono::nanoseconds> opens;
+    std::vector<std::chrono::nanoseconds> closes;
+    opens.reserve(cycles);
+    closes.reserve(cycles);
+    auto failed = false;
+    for (std::size_t i = 0; i < cycles; ++i) {
+        const auto before_open = bench::Clock::now();
+        auto       serial      = Serial::open(path, 115200, reactor);
+        const auto after_open  = bench::Clock::now();
+        if (!serial) {
+            failed = true;
+            break;
+        }
+
+        // Give the reactor something to be busy with.
+        if (load > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        [[maybe_unused]] const auto drained =
+          (*serial)->read_all([](std::span<const char>) {});
+
+        const auto before_close = bench::Clock::now();
+        (*serial)->close();
+        const auto after_close = bench::Clock::now();
+
+        opens.push_back(after_open - before_open);
+        closes.push_back(after_close - before_close);
+    }
+
+    loading.store(false, std::memory_order_relaxed);
+    writer.join();
+    ::close(slave);
+    if (failed) { return std::nullopt; }
+
+    const auto max = [](const std::vector<std::chrono::nanoseconds> &all) {
+        return bench::to_microseconds(
+          all.empty() ? std::chrono::nanoseconds(0) : std::ranges::max(all)
+        );
+    };
+    return Result{
+        .load         = load,
+        .cycles       = opens.size(),
+        .open_p50_us  = bench::to_microseconds(bench::percentile(opens, 50)),
+        .open_p99_us  = bench::to_microseconds(bench::percentile(opens, 99)),
+        .open_max_us  = max(opens),
+        .close_p50_us = bench::to_microseconds(bench::percentile(closes, 50)),
+        .close_p99_us = bench::to_microseconds(bench::percentile(closes, 99)),
+        .close_max_us = max(closes),
+    };
+}
+
+} // namespace
+
+namespace bench
+{
+
+int run_cycle(const std::span<const std::string_view> args)
+{
+    const auto loads =
+      parse_list(option<std::string_view>(args, "--loads", "0,50000000"));
+    const auto cycles  = option<std::size_t>(args, "--cycles", 200);
+    const auto backend = option<std::string_view>(args, "--backend", "epoll")
+                             == "io_uring"
+                           ? Reactor::Backend::IoUring
+                           : Reactor::Backend::Epoll;
+
+    std::print(
+      "{:>10} {:>7} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+      "load B/s",
+      "cycles",
+      "open p50",
+      "open p99",
+      "open max",
+      "close p50",
+      "close p99",
+      "close max"
+    );
+    for (const auto load : loads) {
+        const auto result = measure(backend, load, cycles);
+        if (!result) {
+            std::print(stderr, "[ERROR] failed to set up pty loopback\n");
+            return 1;
+        }
+
+        std::print(
+          "{:>10} {:>7} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} "
+          "{:>10.1f}\n",
+          result->load,
+          result->cycles,
+          result->open_p50_us,
+          result->open_p99_us,
+          result->open_max_us,
+          result->close_p50_us,
+          result->close_p99_us,
+          result->close_max_us
+        );
+    }
+    std::print("(microseconds)\n");
+    return 0;
+}
+
+} // namespace bench
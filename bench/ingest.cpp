@@ -0,0 +1,154 @@
+#include "Benchmarks.hpp"
+#include "Common.hpp"
+#include "RingBuffer.hpp"
+#include "Scrollback.hpp"
+#include "Timeline.hpp"
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <string>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+// One UI frame worth of `chunks` reads of `chunk_size` bytes each, queued
+// the way the reactor queues them: bytes in one ring, one arrival per read
+// in another.
+struct Frame
+{
+    Frame(const std::size_t chunks, const std::size_t chunk_size)
+      : bytes(chunks * chunk_size),
+        arrivals(chunks * sizeof(Timeline::Arrival))
+    {}
+
+    RingBuffer bytes;
+    RingBuffer arrivals;
+};
+
+void fill(
+  Frame                 &frame,
+  const std::size_t      chunks,
+  const std::string_view chunk,
+  std::uint64_t         &offset
+)
+{
+    for (std::size_t i = 0; i < chunks; ++i) {
+        [[maybe_unused]] const auto copied = frame.bytes.write(chunk);
+        offset += chunk.size();
+        [[maybe_unused]] const auto queued =
+          frame.arrivals.write_record(Timeline::Arrival{
+            .end       = offset,
+            .monotonic = static_cast<std::int64_t>(i),
+            .realtime  = 0,
+          });
+    }
+}
+
+// The path App::render_serial_output takes for every connected port.
+void ingest(Frame &frame, Scrollback &scrollback, Timeline &timeline)
+{
+    frame.bytes.read_all([&scrollback](const std::span<const char> bytes) {
+        scrollback.append(bytes);
+    });
+    frame.arrivals.read_records<Timeline::Arrival>(
+      [&timeline](const Timeline::Arrival &arrival) {
+          timeline.append(arrival);
+      }
+    );
+    timeline.discard_before(scrollback.begin());
+}
+
+// What the UI used to do: one std::string per read, merged with
+// fold_left(acc + elem), which copies the accumulator for every chunk.
+[[nodiscard]] std::size_t
+  legacy_merge(const std::vector<std::string> &chunks)
+{
+    const auto merged = std::ranges::fold_left(
+      chunks, std::string{}, [](const auto &acc, const auto &elem) {
+          return acc + elem;
+      }
+    );
+    return merged.size();
+}
+
+} // namespace
+
+namespace bench
+{
+
+int run_ingest(const std::span<const std::string_view> args)
+{
+    const auto chunk_size = option<std::size_t>(args, "--chunk", 16);
+    const auto frames     = option<std::size_t>(args, "--frames", 5);
+    const auto legacy_max = option<std::size_t>(args, "--legacy-max", 30000);
+
+    constexpr auto CHUNK_COUNTS = std::to_array<std::size_t>(
+      { 10'000, 30'000, 100'000, 300'000, 1'000'000 }
+    );
+
+    // Printable bytes with a newline now and then, like a chatty device.
+    std::string chunk(std::max<std::size_t>(chunk_size, 1), 'x');
+    chunk.back() = '\n';
+
+    auto scrollback = Scrollback::create(Scrollback::DEFAULT_CAPACITY);
+    if (!scrollback) { return 1; }
+    Timeline      timeline;
+    std::uint64_t offset = 0;
+
+    std::print(
+      "{:>10} {:>10} {:>12} {:>12} {:>14} {:>14}\n",
+      "chunks",
+      "MB",
+      "ms/frame",
+      "ns/chunk",
+      "legacy ms",
+      "legacy ns/ch"
+    );
+
+    for (const auto chunks : CHUNK_COUNTS) {
+        Frame                                 frame(chunks, chunk.size());
+        std::vector<std::chrono::nanoseconds> samples;
+        for (std::size_t i = 0; i < frames; ++i) {
+            fill(frame, chunks, chunk, offset);
+
+            const auto start = Clock::now();
+            ingest(frame, *scrollback, timeline);
+            samples.push_back(Clock::now() - start);
+        }
+        const auto median = percentile(samples, 50.0);
+
+        std::string legacy_ms = "-";
+        std::string legacy_ns = "-";
+        if (chunks <= legacy_max) {
+            const std::vector<std::string> pieces(chunks, chunk);
+
+            const auto start = Clock::now();
+            const auto size  = legacy_merge(pieces);
+            const auto took  = Clock::now() - start;
+            if (size != chunks * chunk.size()) { return 1; }
+
+            legacy_ms = std::format("{:.3f}", to_microseconds(took) / 1000.0);
+            legacy_ns = std::format(
+              "{:.1f}",
+              to_microseconds(took) * 1000.0 / static_cast<double>(chunks)
+            );
+        }
+
+        std::print(
+          "{:>10} {:>10.2f} {:>12.3f} {:>12.1f} {:>14} {:>14}\n",
+          chunks,
+          static_cast<double>(chunks * chunk.size()) / (1024.0 * 1024.0),
+          to_microseconds(median) / 1000.0,
+          to_microseconds(median) * 1000.0 / static_cast<double>(chunks),
+          legacy_ms,
+          legacy_ns
+        );
+    }
+
+    return 0;
+}
+
+} // namespace bench
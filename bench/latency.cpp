@@ -0,0 +1,263 @@
+#include "Benchmarks.hpp"
+#include "Common.hpp"
+#include "LatencyHistogram.hpp"
+#include "Reactor.hpp"
+#include "Serial.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+struct Result
+{
+    LatencyHistogram latencies;
+    std::uint64_t    frames = 0;
+    std::uint64_t    bytes  = 0;
+};
+
+// Stands in for glfwPostEmptyEvent() and glfwWaitEventsTimeout(): the
+// reactor's activity callback wakes the frame loop.
+class Waker
+{
+  public:
+    void wake()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            woken = true;
+        }
+        condition.notify_one();
+    }
+
+    void wait(const std::chrono::nanoseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait_for(lock, timeout, [this] { return woken; });
+        woken = false;
+    }
+
+  private:
+    std::mutex              mutex;
+    std::condition_variable condition;
+    bool                    woken = false;
+};
+
+// Same as App::run waits when nothing happens.
+constexpr auto IDLE_TIMEOUT = std::chrono::seconds(1);
+
+// Give up on bytes that never show up after this long.
+constexpr auto SETTLE_TIMEOUT = std::chrono::seconds(1);
+
+void spin_for(const std::chrono::nanoseconds duration)
+{
+    const auto until = bench::Clock::now() + duration;
+    while (bench::Clock::now() < until) {}
+}
+
+[[nodiscard]] auto measure(
+  const Reactor::Backend         backend,
+  const std::size_t              rate,
+  const std::size_t              chunk_size,
+  const unsigned                 fps,
+  const std::chrono::nanoseconds frame_cost,
+  const std::chrono::nanoseconds duration
+) -> std::optional<Result>
+{
+    auto pty = bench::PtyPair::open();
+    if (!pty) { return std::nullopt; }
+
+    Waker      waker;
+    const auto reactor = Reactor::spawn(backend, [&waker] { waker.wake(); });
+    if (!reactor) { return std::nullopt; }
+
+    auto serial = Serial::open(pty->slave_path(), 115200, reactor);
+    if (!serial) { return std::nullopt; }
+    auto &port = **serial;
+
+    const auto        start   = bench::Clock::now();
+    std::atomic<bool> writing = true;
+    std::uint64_t     sent    = 0;
+    std::thread       writer([&] {
+        const std::vector<char> bytes(chunk_size, 'x');
+        const auto              interval = std::chrono::duration<double>(
+          static_cast<double>(chunk_size) / static_cast<double>(rate)
+        );
+        for (std::size_t i = 0;; ++i) {
+            const auto due =
+              start
+              + std::chrono::duration_cast<bench::Clock::duration>(
+                interval * static_cast<double>(i)
+              );
+            if (due - start >= duration) { break; }
+            std::this_thread::sleep_until(due);
+            pty->write_all(bytes.data(), bytes.size());
+            sent += bytes.size();
+        }
+        writing.store(false, std::memory_order_release);
+    });
+
+    // The frame loop of App::run without the GUI: pace to `fps`, sleep until
+    // the reactor reports data, drain, spend `frame_cost` on layout and
+    // drawing, present. Every read drained is shown by that frame.
+    const auto frame_interval =
+      fps > 0 ? std::chrono::duration_cast<bench::Clock::duration>(
+                  std::chrono::seconds(1)
+                )
+                  / fps
+              : bench::Clock::duration::zero();
+    std::vector<std::int64_t> arrivals;
+    arrivals.reserve(1024);
+    Result result;
+    auto   last_frame   = bench::Clock::now();
+    auto   last_arrival = last_frame;
+    while (true) {
+        std::this_thread::sleep_until(last_frame + frame_interval);
+        waker.wait(IDLE_TIMEOUT);
+        last_frame = bench::Clock::now();
+
+        reactor->acknowledge_activity();
+        arrivals.clear();
+        result.bytes += port.read_all([](std::span<const char>) {});
+        port.read_arrivals([&arrivals](const Timeline::Arrival &arrival) {
+            arrivals.push_back(arrival.monotonic);
+        });
+        spin_for(frame_cost);
+
+        const auto presented =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+            bench::Clock::now().time_since_epoch()
+          );
+        for (const auto arrival : arrivals) {
+            result.latencies.record(
+              presented - std::chrono::nanoseconds(arrival)
+            );
+        }
+        ++result.frames;
+        if (!arrivals.empty()) { last_arrival = last_frame; }
+
+        if (!writing.load(std::memory_order_acquire)) {
+            if (result.bytes + port.dropped_bytes() >= sent) { break; }
+            if (last_frame - last_arrival > SETTLE_TIMEOUT) { break; }
+        }
+    }
+    writer.join();
+
+    port.close();
+    return result;
+}
+
+} // namespace
+
+namespace bench
+{
+
+int run_latency(const std::span<const std::string_view> args)
+{
+    const auto rate       = option<std::size_t>(args, "--rate", 1'000'000);
+    const auto chunk      = option<std::size_t>(args, "--chunk", 256);
+    const auto fps        = option<unsigned>(args, "--fps", 60);
+    const auto frame_cost = option<double>(args, "--frame-us", 2000.0);
+    const auto seconds    = option<double>(args, "--seconds", 2.0);
+    const auto backend = option<std::string_view>(args, "--backend", "epoll")
+                             == "io_uring"
+                           ? Reactor::Backend::IoUring
+                           : Reactor::Backend::Epoll;
+    const auto json =
+      std::ranges::find(args, std::string_view("--json")) != args.end();
+    if (rate == 0 || chunk == 0) {
+        std::print(stderr, "[ERROR] --rate and --chunk must not be 0\n");
+        return 1;
+    }
+
+    const auto result = measure(
+      backend,
+      rate,
+      chunk,
+      fps,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double, std::micro>(frame_cost)
+      ),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(seconds)
+      )
+    );
+    if (!result) {
+        std::print(stderr, "[ERROR] failed to set up pty loopback\n");
+        return 1;
+    }
+
+    const auto &latencies = result->latencies;
+    const auto  p50       = to_microseconds(latencies.percentile(50));
+    const auto  p99       = to_microseconds(latencies.percentile(99));
+    const auto  p999      = to_microseconds(latencies.percentile(99.9));
+    const auto  max       = to_microseconds(latencies.max());
+
+    if (json) {
+        std::print(
+          "{{\"benchmark\": \"latency\", \"rate\": {}, \"chunk\": {}, "
+          "\"fps\": {}, \"frame_us\": {}, \"frames\": {}, \"reads\": {}, "
+          "\"bytes\": {}, \"latency_p50_us\": {:.3f}, "
+          "\"latency_p99_us\": {:.3f}, \"latency_p999_us\": {:.3f}, "
+          "\"latency_max_us\": {:.3f}, \"buckets\": [",
+          rate,
+          chunk,
+          fps,
+          frame_cost,
+          result->frames,
+          latencies.count(),
+          result->bytes,
+          p50,
+          p99,
+          p999,
+          max
+        );
+        auto first = true;
+        for (std::size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            if (latencies.buckets()[i] == 0) { continue; }
+            std::print(
+              "{}{{\"from_us\": {:.0f}, \"count\": {}}}",
+              first ? "" : ", ",
+              to_microseconds(LatencyHistogram::lower_bound(i)),
+              latencies.buckets()[i]
+            );
+            first = false;
+        }
+        std::print("]}}\n");
+        return 0;
+    }
+
+    std::print(
+      "{} frames, {} reads, {} bytes\n"
+      "byte to present: p50 {:.1f} us, p99 {:.1f} us, p99.9 {:.1f} us, "
+      "max {:.1f} us\n\n",
+      result->frames,
+      latencies.count(),
+      result->bytes,
+      p50,
+      p99,
+      p999,
+      max
+    );
+
+    constexpr std::size_t BAR_WIDTH = 50;
+    const auto            peak      = std::ranges::max(latencies.buckets());
+    for (std::size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+        const auto count = latencies.buckets()[i];
+        if (count == 0) { continue; }
+        std::print(
+          "{:>10.0f} us {:>9} {}\n",
+          to_microseconds(LatencyHistogram::lower_bound(i)),
+          count,
+          std::string(count * BAR_WIDTH / std::max<std::uint64_t>(peak, 1), '#')
+        );
+    }
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,83 @@
+#include "Benchmarks.hpp"
+
+#include <array>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+struct Benchmark
+{
+    std::string_view name;
+    std::string_view description;
+    int (*run)(std::span<const std::string_view>);
+};
+
+constexpr auto BENCHMARKS = std::to_array<Benchmark>({
+  { "backends",
+    "epoll vs io_uring reader, syscalls per MB and latency",
+    bench::run_backends },
+  { "scaling",
+    "N pty ports on one reactor, cpu per port and per MB/s",
+    bench::run_scaling },
+  { "throughput",
+    "fixed rates and chunk sizes, latency, allocs and cpu per MB",
+    bench::run_throughput },
+  { "latency",
+    "read to present latency of a 60 fps frame loop, histogram",
+    bench::run_latency },
+  { "cycle",
+    "connect/disconnect cycles, open and close latency under load",
+    bench::run_cycle },
+  { "reconnect",
+    "device resets through a stable link, time to resume reading",
+    bench::run_reconnect },
+  { "overrun",
+    "tty overrun under CPU stress, with and without reader tuning",
+    bench::run_overrun },
+  { "backpressure",
+    "stalled consumer under each backpressure, drops and holes",
+    bench::run_backpressure },
+  { "ingest",
+    "UI ingestion of 10k to 1M reads per frame, cost per read",
+    bench::run_ingest },
+});
+
+void usage()
+{
+    std::print(stderr, "usage: sesamo_bench <benchmark> [options]\n\n");
+    for (const auto &benchmark : BENCHMARKS) {
+        std::print(
+          stderr, "  {:<12} {}\n", benchmark.name, benchmark.description
+        );
+    }
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int
+{
+    const auto args = std::span(argv, static_cast<std::size_t>(argc))
+                      | std::views::drop(1)
+                      | std::views::transform([](const char *arg) {
+                            return std::string_view(arg);
+                        })
+                      | std::ranges::to<std::vector>();
+    if (args.empty()) {
+        usage();
+        return 1;
+    }
+
+    for (const auto &benchmark : BENCHMARKS) {
+        if (benchmark.name == args.front()) {
+            return benchmark.run(std::span(args).subspan(1));
+        }
+    }
+
+    usage();
+    return 1;
+}
@@ -0,0 +1,251 @@
+#include "Benchmarks.hpp"
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "Serial.hpp"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+struct Config
+{
+    std::string_view name;
+    Reactor::Tuning  tuning;
+};
+
+struct Result
+{
+    std::string   applied;
+    std::size_t   locked   = 0;
+    std::uint64_t offered  = 0;
+    std::uint64_t overrun  = 0;
+    std::uint64_t stalls   = 0;
+    std::uint64_t received = 0;
+    std::uint64_t dropped  = 0;
+};
+
+// The device writes every tick, like a UART whose FIFO fills at the baud
+// rate no matter what the host is doing.
+constexpr auto TICK = std::chrono::milliseconds(1);
+
+// How often the consumer drains the port, well within what its ring holds
+// at the rates this runs at.
+constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(5);
+
+// Memory each stress thread keeps dirtying, enough to push the reactor's
+// working set out of the caches.
+constexpr std::size_t STRESS_FOOTPRINT = 4 * 1024 * 1024;
+constexpr std::size_t CACHE_LINE_SIZE  = 64;
+
+// Like `stress --cpu N --vm N`: spins at normal priority, touching a
+// buffer of its own.
+void stress(const std::atomic<bool> &running)
+{
+    std::vector<char> memory(STRESS_FOOTPRINT);
+    for (std::size_t i = 0; running.load(std::memory_order_relaxed);
+         i = (i + CACHE_LINE_SIZE) % memory.size()) {
+        memory[i] = static_cast<char>(memory[i] + 1);
+    }
+}
+
+// The device side must not be what falls behind, so it runs at the top
+// SCHED_FIFO priority where permitted.
+[[nodiscard]] bool make_realtime()
+{
+    sched_param parameters{};
+    parameters.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters)
+           == 0;
+}
+
+[[nodiscard]] auto measure(
+  const Reactor::Backend         backend,
+  const Config                  &config,
+  const std::size_t              rate,
+  const std::size_t              stressors,
+  const std::chrono::nanoseconds duration,
+  std::atomic<bool>             &device_realtime
+) -> std::optional<Result>
+{
+    auto pty = bench::PtyPair::open();
+    if (!pty) { return std::nullopt; }
+    // A full tty buffer makes writes come up short instead of blocking,
+    // whatever does not fit is what a real port would have overrun.
+    // NOLINTNEXTLINE
+    fcntl(pty->master_fd(), F_SETFL, O_NONBLOCK);
+
+    const auto reactor = Reactor::spawn(backend);
+    if (!reactor) { return std::nullopt; }
+
+    auto serial = Serial::open(pty->slave_path(), 115200, reactor);
+    if (!serial) { return std::nullopt; }
+    auto &port = **serial;
+
+    // After attaching, so the port's buffers count as locked too.
+    Result result;
+    if (config.tuning.requested()) {
+        const auto tuned = reactor->tune(config.tuning);
+        result.applied   = Reactor::describe(config.tuning, tuned);
+        result.locked    = tuned.locked_bytes;
+    } else {
+        result.applied = "-";
+    }
+
+    std::atomic<bool>        running = true;
+    std::vector<std::thread> load;
+    load.reserve(stressors);
+    for (std::size_t i = 0; i < stressors; ++i) {
+        load.emplace_back(stress, std::cref(running));
+    }
+
+    std::atomic<bool> writing = true;
+    std::thread       writer([&] {
+        if (!make_realtime()) {
+            device_realtime.store(false, std::memory_order_relaxed);
+        }
+
+        const auto chunk = std::max<std::size_t>(
+          rate * static_cast<std::size_t>(TICK.count()) / 1000, 1
+        );
+        const std::vector<char> bytes(chunk, 'x');
+        const auto              start = bench::Clock::now();
+        for (auto due = start; due - start < duration; due += TICK) {
+            std::this_thread::sleep_until(due);
+            // NOLINTNEXTLINE
+            const auto written =
+              ::write(pty->master_fd(), bytes.data(), bytes.size());
+            const auto accepted =
+              written < 0 ? 0 : static_cast<std::size_t>(written);
+            result.offered += chunk;
+            if (accepted < chunk) {
+                result.overrun += chunk - accepted;
+                ++result.stalls;
+            }
+        }
+        writing.store(false, std::memory_order_release);
+    });
+
+    while (writing.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(DRAIN_INTERVAL);
+        result.received += port.read_all([](std::span<const char>) {});
+    }
+    writer.join();
+    // Whatever the tty still buffers was not overrun.
+    std::this_thread::sleep_for(DRAIN_INTERVAL);
+    result.received += port.read_all([](std::span<const char>) {});
+
+    running.store(false, std::memory_order_relaxed);
+    for (auto &thread : load) { thread.join(); }
+
+    result.dropped = port.dropped_bytes();
+    port.close();
+    return result;
+}
+
+} // namespace
+
+namespace bench
+{
+
+int run_overrun(const std::span<const std::string_view> args)
+{
+    const auto rate      = option<std::size_t>(args, "--rate", 4'000'000);
+    const auto seconds   = option<double>(args, "--seconds", 2.0);
+    const auto cpu       = option<unsigned>(args, "--cpu", 0);
+    const auto priority  = option<int>(args, "--priority", 50);
+    const auto stressors = option<std::size_t>(
+      args, "--stress", 2 * std::max(std::thread::hardware_concurrency(), 1U)
+    );
+    const auto backend = option<std::string_view>(args, "--backend", "epoll")
+                             == "io_uring"
+                           ? Reactor::Backend::IoUring
+                           : Reactor::Backend::Epoll;
+    if (rate == 0) {
+        std::print(stderr, "[ERROR] --rate must not be 0\n");
+        return 1;
+    }
+
+    const auto tuning = [](
+                          const std::optional<unsigned> pin,
+                          const std::optional<int>      fifo,
+                          const bool                    lock
+                        ) {
+        return Reactor::Tuning{
+            .cpu = pin, .priority = fifo, .lock_memory = lock
+        };
+    };
+    const auto configs = std::to_array<Config>({
+      { "default", tuning({}, {}, false) },
+      { "pinned", tuning(cpu, {}, false) },
+      { "fifo", tuning({}, priority, false) },
+      { "locked", tuning({}, {}, true) },
+      { "all", tuning(cpu, priority, true) },
+    });
+
+    std::print(
+      "{:<8} {:<36} {:>10} {:>10} {:>10} {:>7} {:>10}\n",
+      "config",
+      "applied",
+      "locked KiB",
+      "offered B",
+      "overrun %",
+      "stalls",
+      "dropped %"
+    );
+    std::atomic<bool> device_realtime = true;
+    for (const auto &config : configs) {
+        const auto result = measure(
+          backend,
+          config,
+          rate,
+          stressors,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(seconds)
+          ),
+          device_realtime
+        );
+        if (!result) {
+            std::print(stderr, "[ERROR] failed to set up pty loopback\n");
+            return 1;
+        }
+
+        const auto percent = [&result](const std::uint64_t bytes) {
+            return 100.0 * static_cast<double>(bytes)
+                   / static_cast<double>(std::max<std::uint64_t>(
+                     result->offered, 1
+                   ));
+        };
+        std::print(
+          "{:<8} {:<36} {:>10} {:>10} {:>10.3f} {:>7} {:>10.3f}\n",
+          config.name,
+          result->applied,
+          result->locked / 1024,
+          result->offered,
+          percent(result->overrun),
+          result->stalls,
+          percent(result->dropped)
+        );
+    }
+    std::print(
+      "({} stress threads; overrun is what the tty buffer could not take, "
+      "dropped what the port's ring could not{})\n",
+      stressors,
+      device_realtime.load(std::memory_order_relaxed)
+        ? ""
+        : "; the device writer could not run SCHED_FIFO either"
+    );
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,194 @@
+#include "Benchmarks.hpp"
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "Serial.hpp"
+
+#include <filesystem>
+#include <format>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+struct Result
+{
+    std::size_t down_ms;
+    std::size_t cycles;
+    double      resume_p50_us;
+    double      resume_p99_us;
+    double      resume_max_us;
+    // What the port itself bounded its resume lag to.
+    double      port_lag_us;
+    std::size_t gaps;
+};
+
+// How long a device may take to go away or come back before the
+// benchmark gives up on it.
+constexpr auto STATE_TIMEOUT = std::chrono::seconds(2);
+
+template <typename Predicate>
+[[nodiscard]] bool wait_for(Predicate &&predicate)
+{
+    const auto until = bench::Clock::now() + STATE_TIMEOUT;
+    while (!predicate()) {
+        if (bench::Clock::now() > until) { return false; }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return true;
+}
+
+// Points `link` at `target` the way udev does: the name appears at once,
+// fully formed.
+[[nodiscard]] bool publish(
+  const std::filesystem::path &link,
+  const std::filesystem::path &target
+)
+{
+    auto staged = link;
+    staged += ".new";
+    std::error_code error;
+    std::filesystem::remove(staged, error);
+    std::filesystem::create_symlink(target, staged, error);
+    if (!error) { std::filesystem::rename(staged, link, error); }
+    return !error;
+}
+
+[[nodiscard]] auto measure(
+  const Reactor::Backend       backend,
+  const std::filesystem::path &link,
+  const std::size_t            down_ms,
+  const std::size_t            up_ms,
+  const std::size_t            cycles
+) -> std::optional<Result>
+{
+    auto device = bench::PtyPair::open();
+    if (!device || !publish(link, device->slave_path())) {
+        return std::nullopt;
+    }
+
+    const auto reactor = Reactor::spawn(backend);
+    if (!reactor) { return std::nullopt; }
+
+    // Opened through the link, which is what the port reopens by.
+    const auto opened = Serial::open(link, 115200, reactor);
+    if (!opened) { return std::nullopt; }
+    const auto serial = *opened;
+    serial->reconnect(true);
+
+    std::vector<std::chrono::nanoseconds> resumes;
+    resumes.reserve(cycles);
+    std::size_t gaps   = 0;
+    auto        failed = false;
+    for (std::size_t i = 0; i < cycles; ++i) {
+        // A port failing again right after it came back is retried more
+        // slowly, so the device runs for a while between resets.
+        std::this_thread::sleep_for(std::chrono::milliseconds(up_ms));
+
+        // The device resets: its tty hangs up and its link goes away.
+        device.reset();
+        std::error_code error;
+        std::filesystem::remove(link, error);
+        if (!wait_for([&] { return serial->is_reconnecting(); })) {
+            failed = true;
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(down_ms));
+
+        // And shows up again, most likely under another pts number.
+        device = bench::PtyPair::open();
+        if (!device || !publish(link, device->slave_path())) {
+            failed = true;
+            break;
+        }
+        const auto back = bench::Clock::now();
+        if (!wait_for([&] { return serial->is_connected(); })) {
+            failed = true;
+            break;
+        }
+        resumes.push_back(bench::Clock::now() - back);
+
+        gaps += serial->read_gaps([](const Serial::Gap &) {});
+    }
+
+    const auto lag = serial->stats().resume_lag;
+    serial->close();
+    std::error_code error;
+    std::filesystem::remove(link, error);
+    if (failed) { return std::nullopt; }
+
+    return Result{
+        .down_ms       = down_ms,
+        .cycles        = resumes.size(),
+        .resume_p50_us = bench::to_microseconds(bench::percentile(resumes, 50)),
+        .resume_p99_us = bench::to_microseconds(bench::percentile(resumes, 99)),
+        .resume_max_us = bench::to_microseconds(std::ranges::max(resumes)),
+        .port_lag_us   = bench::to_microseconds(lag),
+        .gaps          = gaps,
+    };
+}
+
+} // namespace
+
+namespace bench
+{
+
+int run_reconnect(const std::span<const std::string_view> args)
+{
+    const auto downs =
+      parse_list(option<std::string_view>(args, "--downs", "10,100,1000"));
+    const auto up      = option<std::size_t>(args, "--up-ms", 500);
+    const auto cycles  = option<std::size_t>(args, "--cycles", 10);
+    const auto backend = option<std::string_view>(args, "--backend", "epoll")
+                             == "io_uring"
+                           ? Reactor::Backend::IoUring
+                           : Reactor::Backend::Epoll;
+    if (cycles == 0) {
+        std::print(stderr, "[ERROR] --cycles must not be 0\n");
+        return 1;
+    }
+
+    // Stands in for /dev/serial/by-id/<device>.
+    const auto link = std::filesystem::temp_directory_path()
+                      / std::format("sesamo-bench-{}", getpid());
+
+    std::print(
+      "{:>8} {:>7} {:>11} {:>11} {:>11} {:>11} {:>5}\n",
+      "down ms",
+      "cycles",
+      "resume p50",
+      "resume p99",
+      "resume max",
+      "port bound",
+      "gaps"
+    );
+    for (const auto down : downs) {
+        const auto result = measure(backend, link, down, up, cycles);
+        if (!result) {
+            std::print(stderr, "[ERROR] failed to reset the pty device\n");
+            return 1;
+        }
+
+        std::print(
+          "{:>8} {:>7} {:>11.1f} {:>11.1f} {:>11.1f} {:>11.1f} {:>5}\n",
+          result->down_ms,
+          result->cycles,
+          result->resume_p50_us,
+          result->resume_p99_us,
+          result->resume_max_us,
+          result->port_lag_us,
+          result->gaps
+        );
+    }
+    std::print(
+      "(microseconds from the device node reappearing to the port reading "
+      "again, bounded by the {} ms backoff cap)\n",
+      Serial::RECONNECT_BACKOFF_MAX.count()
+    );
+    return 0;
+}
+
+} // namespace bench
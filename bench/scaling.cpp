@@ -0,0 +1,149 @@
+#include "Benchmarks.hpp"
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "Serial.hpp"
+
+#include <thread>
+#include <print>
+
+namespace
+{
+
+struct Result
+{
+    std::size_t ports;
+    double      megabytes_per_second;
+    double      cpu_percent;
+    std::size_t dropped;
+};
+
+[[nodiscard]] auto measure(
+  const Reactor::Backend       backend,
+  const std::size_t            port_count,
+  const std::size_t            bytes_per_second,
+  const std::chrono::nanoseconds duration
+) -> std::optional<Result>
+{
+    const auto reactor = Reactor::spawn(backend);
+    if (!reactor) { return std::nullopt; }
+
+    std::vector<bench::PtyPair>          ptys;
+    std::vector<std::shared_ptr<Serial>> ports;
+    for (std::size_t i = 0; i < port_count; ++i) {
+        auto pty = bench::PtyPair::open();
+        if (!pty) { return std::nullopt; }
+        auto serial = Serial::open(pty->slave_path(), 115200, reactor);
+        if (!serial) { return std::nullopt; }
+        ptys.push_back(std::move(*pty));
+        ports.push_back(std::move(*serial));
+    }
+
+    // Every port gets its share of bytes once per millisecond, roughly how
+    // a UART with a small FIFO delivers to the tty layer.
+    constexpr auto TICK = std::chrono::milliseconds(1);
+    const auto tick_bytes = std::max<std::size_t>(bytes_per_second / 1000, 1);
+
+    std::atomic<bool> writing = true;
+    std::thread       writer([&] {
+        std::vector<char> line(tick_bytes, 'x');
+        line.back() = '\n';
+
+        auto next = bench::Clock::now();
+        while (writing.load(std::memory_order_relaxed)) {
+            for (const auto &pty : ptys) {
+                pty.write_all(line.data(), line.size());
+            }
+            next += TICK;
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    // The consumer drains at display rate like the UI would.
+    constexpr auto FRAME = std::chrono::microseconds(16'667);
+
+    const auto cpu_before = reactor->cpu_time();
+    const auto start      = bench::Clock::now();
+    std::size_t received  = 0;
+    while (bench::Clock::now() - start < duration) {
+        for (const auto &port : ports) {
+            received += port->read_all([](std::span<const char>) {});
+        }
+        std::this_thread::sleep_for(FRAME);
+    }
+    const auto elapsed = bench::Clock::now() - start;
+    const auto cpu     = reactor->cpu_time() - cpu_before;
+
+    writing.store(false, std::memory_order_relaxed);
+    writer.join();
+
+    std::size_t dropped = 0;
+    for (const auto &port : ports) {
+        dropped += port->dropped_bytes();
+        port->close();
+    }
+
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+    return Result{
+        .ports                = port_count,
+        .megabytes_per_second = static_cast<double>(received)
+                                / (1024.0 * 1024.0) / seconds,
+        .cpu_percent =
+          100.0 * std::chrono::duration<double>(cpu).count() / seconds,
+        .dropped = dropped,
+    };
+}
+
+} // namespace
+
+namespace bench
+{
+
+int run_scaling(const std::span<const std::string_view> args)
+{
+    const auto max_ports = option<std::size_t>(args, "--ports", 128);
+    const auto rate      = option<std::size_t>(args, "--rate", 11'520);
+    const auto seconds   = option<double>(args, "--seconds", 2.0);
+    const auto backend   = option<std::string_view>(args, "--backend", "epoll")
+                               == "io_uring"
+                           ? Reactor::Backend::IoUring
+                           : Reactor::Backend::Epoll;
+
+    std::print(
+      "{:>6} {:>10} {:>10} {:>14} {:>16} {:>10}\n",
+      "ports",
+      "MB/s",
+      "cpu %",
+      "cpu %/port",
+      "cpu %/(MB/s)",
+      "dropped"
+    );
+
+    for (std::size_t ports = 1; ports <= max_ports; ports *= 2) {
+        const auto result = measure(
+          backend,
+          ports,
+          rate,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(seconds)
+          )
+        );
+        if (!result) {
+            std::print(stderr, "[ERROR] failed to set up {} ports\n", ports);
+            return 1;
+        }
+
+        std::print(
+          "{:>6} {:>10.3f} {:>10.2f} {:>14.4f} {:>16.3f} {:>10}\n",
+          result->ports,
+          result->megabytes_per_second,
+          result->cpu_percent,
+          result->cpu_percent / static_cast<double>(result->ports),
+          result->cpu_percent / result->megabytes_per_second,
+          result->dropped
+        );
+    }
+
+    return 0;
+}
+
+} // namespace bench
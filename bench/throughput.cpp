@@ -0,0 +1,308 @@
+#include "Benchmarks.hpp"
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "Serial.hpp"
+
+#include <atomic>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+struct Result
+{
+    Reactor::Backend backend;
+    std::size_t      rate;
+    std::size_t      chunk;
+    // None of these exist when nothing arrived at all.
+    std::optional<double> megabytes_per_second;
+    double                latency_p50_us;
+    double                latency_p99_us;
+    double                latency_p999_us;
+    std::optional<double> allocations_per_megabyte;
+    std::optional<double> cpu_ms_per_megabyte;
+    std::uint64_t         dropped;
+};
+
+// One write() of the driver: where it ends in the stream and when it
+// started.
+struct Sent
+{
+    std::uint64_t            end = 0;
+    bench::Clock::time_point time;
+};
+
+// Bounds the bookkeeping of unthrottled runs, which is allocated up front
+// so it does not show up in the allocation count.
+constexpr std::size_t MAX_CHUNKS = 1 << 20;
+
+// Give up on bytes that never show up (dropped) after this long.
+constexpr auto SETTLE_TIMEOUT = std::chrono::seconds(1);
+
+[[nodiscard]] std::string_view to_string(const Reactor::Backend backend)
+{
+    switch (backend) {
+        case Reactor::Backend::Epoll: return "epoll";
+        case Reactor::Backend::IoUring: return "io_uring";
+    }
+    return "unknown";
+}
+
+[[nodiscard]] auto measure(
+  const Reactor::Backend         backend,
+  const std::size_t              rate,
+  const std::size_t              chunk_size,
+  const std::chrono::nanoseconds duration
+) -> std::optional<Result>
+{
+    auto pty = bench::PtyPair::open();
+    if (!pty) { return std::nullopt; }
+
+    const auto reactor = Reactor::spawn(backend);
+    if (!reactor) { return std::nullopt; }
+
+    auto serial = Serial::open(pty->slave_path(), 115200, reactor);
+    if (!serial) { return std::nullopt; }
+    auto &port = **serial;
+
+    const auto seconds = std::chrono::duration<double>(duration).count();
+    const auto capacity =
+      rate == 0 ? MAX_CHUNKS
+                : std::min(
+                    MAX_CHUNKS,
+                    static_cast<std::size_t>(
+                      static_cast<double>(rate) * seconds
+                      / static_cast<double>(chunk_size)
+                    ) + 1
+                  );
+    const std::vector<char>               bytes(chunk_size, 'x');
+    std::vector<Sent>                     sent(capacity);
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(capacity);
+    std::atomic<std::size_t> published = 0;
+    std::atomic<bool>        writing   = true;
+
+    const auto allocations_before = bench::allocations();
+    const auto cpu_before         = reactor->cpu_time();
+    const auto start              = bench::Clock::now();
+
+    // Chunks are due at fixed points in time, the writer catches up on
+    // whatever it overslept instead of drifting.
+    std::thread writer([&] {
+        const auto interval = std::chrono::duration<double>(
+          rate == 0 ? 0.0
+                    : static_cast<double>(chunk_size)
+                        / static_cast<double>(rate)
+        );
+        for (std::size_t i = 0; i < capacity; ++i) {
+            const auto due =
+              start
+              + std::chrono::duration_cast<bench::Clock::duration>(
+                interval * static_cast<double>(i)
+              );
+            if (due - start >= duration) { break; }
+            if (due > bench::Clock::now()) {
+                std::this_thread::sleep_until(due);
+            }
+            if (bench::Clock::now() - start >= duration) { break; }
+
+            sent[i] = { .end  = (i + 1) * chunk_size,
+                        .time = bench::Clock::now() };
+            pty->write_all(bytes.data(), bytes.size());
+            published.store(i + 1, std::memory_order_release);
+        }
+        writing.store(false, std::memory_order_release);
+    });
+
+    // The consumer spins on read_all(), so a chunk's latency is the time
+    // from its write() to the first read_all() that hands out its last byte.
+    std::uint64_t received     = 0;
+    std::size_t   next         = 0;
+    auto          last_arrival = bench::Clock::now();
+    while (true) {
+        const auto count = port.read_all([](std::span<const char>) {});
+        const auto now   = bench::Clock::now();
+        received        += count;
+        if (count > 0) { last_arrival = now; }
+
+        const auto done  = !writing.load(std::memory_order_acquire);
+        const auto total = published.load(std::memory_order_acquire);
+        for (; next < total && sent[next].end <= received; ++next) {
+            latencies.push_back(now - sent[next].time);
+        }
+
+        if (done && next == published.load(std::memory_order_acquire)) {
+            break;
+        }
+        if (done && now - last_arrival > SETTLE_TIMEOUT) { break; }
+        if (count == 0) { std::this_thread::yield(); }
+    }
+    const auto elapsed     = last_arrival - start;
+    const auto cpu         = reactor->cpu_time() - cpu_before;
+    const auto allocations = bench::allocations() - allocations_before;
+    writer.join();
+
+    const auto megabytes = static_cast<double>(received) / (1024.0 * 1024.0);
+    const auto taken     = std::chrono::duration<double>(elapsed).count();
+    const auto per_megabyte =
+      [megabytes](const double value) -> std::optional<double> {
+        if (megabytes == 0) { return std::nullopt; }
+        return value / megabytes;
+    };
+    const auto result = Result{
+        .backend              = reactor->backend(),
+        .rate                 = rate,
+        .chunk                = chunk_size,
+        .megabytes_per_second = megabytes > 0 && taken > 0
+                                  ? std::optional(megabytes / taken)
+                                  : std::nullopt,
+        .latency_p50_us =
+          bench::to_microseconds(bench::percentile(latencies, 50)),
+        .latency_p99_us =
+          bench::to_microseconds(bench::percentile(latencies, 99)),
+        .latency_p999_us =
+          bench::to_microseconds(bench::percentile(latencies, 99.9)),
+        .allocations_per_megabyte =
+          per_megabyte(static_cast<double>(allocations)),
+        .cpu_ms_per_megabyte =
+          per_megabyte(std::chrono::duration<double, std::milli>(cpu).count()),
+        .dropped = port.dropped_bytes(),
+    };
+
+    port.close();
+    return result;
+}
+
+// `value` with `decimals` 2 or 4, `none` if there is no value.
+[[nodiscard]] std::string format_value(
+  const std::optional<double> value,
+  const int                   decimals,
+  const std::string_view      none
+)
+{
+    if (!value) { return std::string(none); }
+    return decimals == 2 ? std::format("{:.2f}", *value)
+                         : std::format("{:.4f}", *value);
+}
+
+void print_table_header()
+{
+    std::print(
+      "{:<10} {:>10} {:>7} {:>9} {:>9} {:>9} {:>9} {:>9} {:>9} {:>9}\n",
+      "backend",
+      "rate B/s",
+      "chunk",
+      "MB/s",
+      "p50 us",
+      "p99 us",
+      "p999 us",
+      "allocs/MB",
+      "cpu ms/MB",
+      "dropped"
+    );
+}
+
+void print_table_row(const Result &result)
+{
+    std::print(
+      "{:<10} {:>10} {:>7} {:>9} {:>9.1f} {:>9.1f} {:>9.1f} {:>9} {:>9} "
+      "{:>9}\n",
+      to_string(result.backend),
+      result.rate == 0 ? std::string("max") : std::to_string(result.rate),
+      result.chunk,
+      format_value(result.megabytes_per_second, 2, "-"),
+      result.latency_p50_us,
+      result.latency_p99_us,
+      result.latency_p999_us,
+      format_value(result.allocations_per_megabyte, 2, "-"),
+      format_value(result.cpu_ms_per_megabyte, 2, "-"),
+      result.dropped
+    );
+}
+
+void print_json(const std::vector<Result> &results)
+{
+    std::print("{{\"benchmark\": \"throughput\", \"results\": [");
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto &result = results[i];
+        std::print(
+          "{}\n  {{\"backend\": \"{}\", \"rate\": {}, \"chunk\": {}, "
+          "\"megabytes_per_second\": {}, \"latency_p50_us\": {:.3f}, "
+          "\"latency_p99_us\": {:.3f}, \"latency_p999_us\": {:.3f}, "
+          "\"allocations_per_megabyte\": {}, "
+          "\"cpu_ms_per_megabyte\": {}, \"dropped\": {}}}",
+          i == 0 ? "" : ",",
+          to_string(result.backend),
+          result.rate,
+          result.chunk,
+          format_value(result.megabytes_per_second, 4, "null"),
+          result.latency_p50_us,
+          result.latency_p99_us,
+          result.latency_p999_us,
+          format_value(result.allocations_per_megabyte, 4, "null"),
+          format_value(result.cpu_ms_per_megabyte, 4, "null"),
+          result.dropped
+        );
+    }
+    std::print("\n]}}\n");
+}
+
+} // namespace
+
+namespace bench
+{
+
+int run_throughput(const std::span<const std::string_view> args)
+{
+    const auto rates = parse_list(
+      option<std::string_view>(args, "--rates", "100000,1000000,0")
+    );
+    const auto chunks =
+      parse_list(option<std::string_view>(args, "--chunks", "64,1024,16384"));
+    const auto seconds = option<double>(args, "--seconds", 1.0);
+    const auto backend = option<std::string_view>(args, "--backend", "epoll")
+                             == "io_uring"
+                           ? Reactor::Backend::IoUring
+                           : Reactor::Backend::Epoll;
+    const auto json =
+      std::ranges::find(args, std::string_view("--json")) != args.end();
+
+    if (!json) { print_table_header(); }
+
+    std::vector<Result> results;
+    for (const auto rate : rates) {
+        for (const auto chunk : chunks) {
+            if (chunk == 0) { continue; }
+
+            const auto result = measure(
+              backend,
+              rate,
+              chunk,
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::duration<double>(seconds)
+              )
+            );
+            if (!result) {
+                std::print(stderr, "[ERROR] failed to set up pty loopback\n");
+                return 1;
+            }
+
+            if (json) {
+                results.push_back(*result);
+            } else {
+                print_table_row(*result);
+            }
+        }
+    }
+
+    if (json) { print_json(results); }
+    return 0;
+}
+
+} // namespace bench
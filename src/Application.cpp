@@ -1,11 +1,18 @@
 #include "Application.hpp"
+#include "Trace.hpp"
 #include "../resources/jet_brains_mono_regular.hpp"
 
 #include <algorithm>
-#include <filesystem>
+#include <cfloat>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <format>
 #include <GLFW/glfw3.h>
 #include <print>
 #include <ranges>
+#include <span>
+#include <thread>
 
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
@@ -14,52 +21,216 @@
 namespace
 {
 
-[[nodiscard]] auto load_available_ttys(const auto &path)
+// "/dev/ttyUSB0  FT232R USB UART (0403:6001)", or the driver when the
+// device does not name itself.
+[[nodiscard]] std::string label(const DeviceRegistry::Device &device)
 {
-    const auto iterator = std::filesystem::directory_iterator(path);
-
-    const auto stringify = [](const auto &dir_entry) {
-        return dir_entry.path().string();
-    };
-
-    // FIXME: A more correct approach would be to read
-    // "/sys/class/tty/" and i think check for those symlinks
-    // that point to something other than " /../../devices/virtual"
-    // so it is an actual physical device.
-    const auto is_valid_tty = [](const auto &str) {
-        constexpr std::string_view prefix = "/dev/tty";
-        if (!str.starts_with(prefix)) { return false; }
-
-        const auto substr = str.substr(prefix.size());
-        return std::ranges::find_if(
-                 substr, [](const char ch) { return !std::isdigit(ch); }
-               )
-               != substr.end();
-    };
+    if (device.vendor_id == 0) {
+        return device.driver.empty()
+                 ? device.path
+                 : std::format("{}  {}", device.path, device.driver);
+    }
 
-    auto ret = iterator | std::views::transform(stringify)
-               | std::views::filter(is_valid_tty)
-               | std::ranges::to<std::vector>();
+    return std::format(
+      "{}  {} ({:04x}:{:04x})",
+      device.path,
+      device.product.empty() ? device.driver : device.product,
+      device.vendor_id,
+      device.product_id
+    );
+}
 
-    std::ranges::sort(ret);
-    return ret;
+[[nodiscard]] std::string details(const DeviceRegistry::Device &device)
+{
+    auto text = std::format("{} on {}", device.driver, device.subsystem);
+    if (!device.manufacturer.empty()) {
+        text += std::format("\n{}", device.manufacturer);
+    }
+    if (!device.serial.empty()) {
+        text += std::format("\nserial {}", device.serial);
+    }
+    if (!device.by_id.empty()) { text += std::format("\n{}", device.by_id); }
+    return text;
 }
 
 void glfw_error_callback(int error, const char *description)
 {
     std::print(stderr, "[ERROR] GLFW Error ({}): {}\n", error, description);
 }
+
+[[nodiscard]] std::int64_t monotonic_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()
+    )
+      .count();
+}
+
+// Fills the timestamp column for a line, either seconds since the port was
+// connected or the local wall clock time when it was captured.
+[[nodiscard]] std::string_view format_timestamp(
+  std::span<char>                       out,
+  const std::optional<Timeline::Time> &time,
+  const std::int64_t                    origin,
+  const bool                            wall_clock
+)
+{
+    std::array<char, Timeline::TIME_TEXT_SIZE> text_buffer{};
+    std::string_view                           text;
+    if (time && wall_clock && time->realtime != 0) {
+        text = Timeline::format_wall_clock(text_buffer, time->realtime);
+    } else if (time) {
+        text = Timeline::format_elapsed(text_buffer, time->monotonic - origin);
+    }
+
+    const auto result = std::format_to_n(
+      out.data(), static_cast<std::ptrdiff_t>(out.size()), "{:>15} ", text
+    );
+    return { out.data(),
+             std::min(out.size(), static_cast<std::size_t>(result.size)) };
+}
+
+// One figure of the performance overlay: its latest value above a histogram
+// of the whole history, labelled with its average and peak.
+void plot_series(
+  const std::string_view    label,
+  const FrameStats::Series &series,
+  const std::string_view    unit
+)
+{
+    constexpr std::size_t TEXT_SIZE   = 64;
+    constexpr float       PLOT_WIDTH  = 240.0F;
+    constexpr float       PLOT_HEIGHT = 40.0F;
+
+    std::array<char, TEXT_SIZE> text{};
+    std::format_to_n(
+      text.data(),
+      text.size() - 1,
+      "avg {:.2f} max {:.2f} {}",
+      series.average(),
+      series.max(),
+      unit
+    );
+
+    // NOLINTNEXTLINE
+    ImGui::Text(
+      "%.*s: %.2f %.*s",
+      static_cast<int>(label.size()),
+      label.data(),
+      static_cast<double>(series.last()),
+      static_cast<int>(unit.size()),
+      unit.data()
+    );
+    ImGui::PushID(label.data(), label.data() + label.size());
+    ImGui::PlotHistogram(
+      "",
+      series.data(),
+      static_cast<int>(FrameStats::HISTORY),
+      series.offset(),
+      text.data(),
+      0.0F,
+      FLT_MAX,
+      ImVec2(PLOT_WIDTH, PLOT_HEIGHT)
+    );
+    ImGui::PopID();
+}
+
+// Distribution of the byte to pixel latency since the overlay was opened,
+// only the range of buckets that counted anything is plotted.
+void plot_latencies(
+  const LatencyHistogram                             &latencies,
+  const std::array<float, LatencyHistogram::BUCKETS> &buckets
+)
+{
+    constexpr std::size_t TEXT_SIZE   = 64;
+    constexpr float       PLOT_WIDTH  = 240.0F;
+    constexpr float       PLOT_HEIGHT = 60.0F;
+
+    const auto milliseconds = [](const std::chrono::nanoseconds duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    // NOLINTNEXTLINE
+    ImGui::Text(
+      "latency p50 %.2f p99 %.2f p99.9 %.2f max %.2f ms",
+      milliseconds(latencies.percentile(50)),
+      milliseconds(latencies.percentile(99)),
+      milliseconds(latencies.percentile(99.9)),
+      milliseconds(latencies.max())
+    );
+    if (latencies.count() == 0) { return; }
+
+    const auto &counts = latencies.buckets();
+    const auto  first  = static_cast<std::size_t>(
+      std::ranges::find_if(counts, [](const auto count) { return count > 0; })
+      - counts.begin()
+    );
+    const auto last = static_cast<std::size_t>(
+      std::ranges::find_if(
+        counts | std::views::reverse,
+        [](const auto count) { return count > 0; }
+      ).base()
+      - counts.begin()
+    );
+
+    std::array<char, TEXT_SIZE> text{};
+    std::format_to_n(
+      text.data(),
+      text.size() - 1,
+      "{:.3f} to {:.3f} ms",
+      milliseconds(LatencyHistogram::lower_bound(first)),
+      milliseconds(LatencyHistogram::lower_bound(last))
+    );
+    ImGui::PlotHistogram(
+      "##Latencies",
+      buckets.data() + first,
+      static_cast<int>(last - first),
+      0,
+      text.data(),
+      0.0F,
+      FLT_MAX,
+      ImVec2(PLOT_WIDTH, PLOT_HEIGHT)
+    );
+}
 } // namespace
 
-auto App::spawn() -> std::unique_ptr<App>
+auto App::spawn(const Options &options) -> std::unique_ptr<App>
 {
     glfwSetErrorCallback(glfw_error_callback);
 
+    // Before anything that may call glfwPostEmptyEvent() from its own
+    // thread.
     if (glfwInit() == 0) {
         std::print(stderr, "[ERROR] Glfw failed initialize\n");
         return nullptr;
     }
 
+    // Data landing on any port wakes the UI out of glfwWaitEventsTimeout.
+    auto reactor =
+      Reactor::spawn(options.reader_backend, [] { glfwPostEmptyEvent(); });
+    if (!reactor) {
+        std::print(stderr, "[ERROR] failed to start the serial reactor\n");
+        glfwTerminate();
+        return nullptr;
+    }
+
+    std::string reader_tuning;
+    if (options.reader_tuning.requested()) {
+        reader_tuning = Reactor::describe(
+          options.reader_tuning, reactor->tune(options.reader_tuning)
+        );
+        std::print(stderr, "reader thread: {}\n", reader_tuning);
+    }
+
+    // So does a port being plugged in or out.
+    auto devices = DeviceRegistry::spawn([] { glfwPostEmptyEvent(); });
+    if (!devices) {
+        std::print(stderr, "[ERROR] failed to start the device registry\n");
+        reactor.reset();
+        glfwTerminate();
+        return nullptr;
+    }
+
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -68,6 +239,9 @@ auto App::spawn() -> std::unique_ptr<App>
       glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "sesamo", nullptr, nullptr);
     if (window == nullptr) {
         std::print(stderr, "[ERROR] Glfw failed to create window\n");
+        devices.reset();
+        reactor.reset();
+        glfwTerminate();
         return nullptr;
     }
 
@@ -91,18 +265,38 @@ auto App::spawn() -> std::unique_ptr<App>
     );
     io.Fonts->Build();
 
-    return std::unique_ptr<App>(new App{ window });
+    auto app = std::unique_ptr<App>(
+      new App{ window, options, std::move(reactor), std::move(devices) }
+    );
+    app->reader_tuning = std::move(reader_tuning);
+    return app;
 }
 
-App::App(GLFWwindow *window)
-  : window{ window }
+App::App(
+  GLFWwindow                     *window,
+  const Options                  &options,
+  std::shared_ptr<Reactor>        reactor,
+  std::unique_ptr<DeviceRegistry> devices
+)
+  : window{ window },
+    options{ options },
+    reactor{ std::move(reactor) },
+    devices{ std::move(devices) },
+    selected_backpressure{ options.buffering.policy }
 {
-    available_ttys = load_available_ttys(TTY_PATH);
+    refresh_ttys();
 }
 
 App::~App()
 {
-    if (connected) { serial->close(); }
+    for (auto &port : ports) {
+        if (port.connected) { port.serial->close(); }
+    }
+    ports.clear();
+    // Both wake the UI from their own threads, they have to be gone
+    // before GLFW is.
+    devices.reset();
+    reactor.reset();
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -111,34 +305,168 @@ App::~App()
     glfwTerminate();
 }
 
-void App::connect_to_serial()
+App::Port *App::active_port()
+{
+    return selected_port < ports.size() ? &ports[selected_port] : nullptr;
+}
+
+const App::Port *App::active_port() const
+{
+    return selected_port < ports.size() ? &ports[selected_port] : nullptr;
+}
+
+void App::Port::clear()
 {
-    if (connected) { return; }
+    scrollback->clear();
+    timeline.discard_before(scrollback->end());
+}
 
-    const auto baud_rate =
-      std::ranges::find_if(BAUD_RATES, [this](const auto &pair) {
-          return pair.first == selected_baud_rate;
-      });
-    assert(baud_rate != BAUD_RATES.end());
+void App::Port::append(std::span<const char> bytes)
+{
+    while (true) {
+        mark_notes();
+        if (bytes.empty()) { return; }
+
+        // Up to the next note, notes are queued before their bytes.
+        const auto until = notes.empty() ? bytes.size()
+                                         : std::min<std::uint64_t>(
+                                             bytes.size(),
+                                             notes.front().end - consumed
+                                           );
+        const auto head = bytes.first(static_cast<std::size_t>(until));
+        scrollback->append(head);
+        consumed   += head.size();
+        line_start  = head.back() == '\n';
+        bytes       = bytes.subspan(head.size());
+    }
+}
 
-    const auto result =
-      Serial::open(available_ttys[selected_tty], baud_rate->second);
-    if (!result) {
-        quit = true;
+void App::Port::discard(const std::uint64_t bytes)
+{
+    mark_notes();
+    const auto mark = std::format(
+      "{}[dropped {} bytes]\n", line_start ? "" : "\n", bytes
+    );
+    scrollback->append(mark);
+    // Timestamps past the hole move back by what is missing.
+    marks.emplace_back(consumed, mark.size() - bytes);
+    consumed   += bytes;
+    line_start  = true;
+}
+
+void App::Port::note(const std::uint64_t end, std::string text)
+{
+    notes.insert(
+      std::ranges::upper_bound(notes, end, {}, &Note::end),
+      Note{ .end = end, .text = std::move(text) }
+    );
+}
+
+void App::Port::mark_notes()
+{
+    while (!notes.empty() && notes.front().end <= consumed) {
+        const auto mark =
+          std::format("{}{}\n", line_start ? "" : "\n", notes.front().text);
+        scrollback->append(mark);
+        marks.emplace_back(consumed, mark.size());
+        line_start = true;
+        notes.pop_front();
+    }
+}
+
+void App::connect_to_serial()
+{
+    if (available_ttys.empty()) { return; }
+    const auto &path = available_ttys[selected_tty].path;
+
+    // Connecting to a tty that already has a tab reuses (and focuses) it.
+    auto existing = std::ranges::find(ports, path, &Port::path);
+    if (existing != ports.end() && existing->connected) {
+        focus_port = static_cast<std::size_t>(existing - ports.begin());
         return;
     }
-    serial    = *result;
-    connected = true;
+
+    // A synthetic source is just a pty with a generator on the other end,
+    // the tab keeps showing its "synthetic:" name.
+    std::unique_ptr<Synthetic> synthetic;
+    if (const auto pattern = Synthetic::parse(path)) {
+        synthetic = Synthetic::start(*pattern, selected_synthetic_rate);
+        if (!synthetic) { return; }
+    }
+
+    auto buffering   = options.buffering;
+    buffering.policy = selected_backpressure;
+    const auto result = Serial::open(
+      synthetic ? synthetic->path() : path,
+      selected_baud_rate,
+      reactor,
+      buffering
+    );
+    if (!result) { return; }
+
+    if (existing == ports.end()) {
+        auto scrollback = Scrollback::create(options.scrollback_capacity);
+        if (!scrollback) {
+            (*result)->close();
+            return;
+        }
+
+        existing             = ports.emplace(ports.end());
+        existing->path       = path;
+        existing->scrollback = std::move(scrollback);
+    }
+    existing->serial       = *result;
+    existing->synthetic    = std::move(synthetic);
+    existing->connected    = true;
+    existing->base         = existing->scrollback->end();
+    existing->connected_at = monotonic_now();
+    existing->consumed     = 0;
+    existing->notes.clear();
+    existing->marks.clear();
+    existing->counters.reset();
+    existing->serial->capture_realtime(wall_clock_timestamps);
+    existing->serial->reconnect(auto_reconnect);
+    focus_port = static_cast<std::size_t>(existing - ports.begin());
 }
 
 void App::disconnect_from_serial()
 {
-    if (!connected) { return; }
-    serial->close();
-    connected = false;
+    auto *port = active_port();
+    if (port == nullptr || !port->connected) { return; }
+    port->serial->close();
+    port->synthetic.reset();
+    port->connected = false;
+}
+
+void App::close_port(const std::size_t index)
+{
+    if (ports[index].connected) { ports[index].serial->close(); }
+    ports.erase(ports.begin() + static_cast<std::ptrdiff_t>(index));
+    if (selected_port >= ports.size() && selected_port > 0) { --selected_port; }
 }
 
-void App::clear_received_messages_buffer() { received_messages_buffer.clear(); }
+void App::clear_received_messages_buffer()
+{
+    if (auto *port = active_port()) { port->clear(); }
+}
+
+void App::dump_trace() const
+{
+    if (trace::dump(options.trace)) {
+        std::print(stderr, "trace written to {}\n", options.trace);
+    }
+}
+
+void App::select_baud_rate(const std::uint32_t baud_rate)
+{
+    selected_baud_rate = baud_rate;
+    selected_baud_rate_label.fill('\0');
+    std::to_chars(
+      selected_baud_rate_label.data(),
+      selected_baud_rate_label.data() + selected_baud_rate_label.size() - 1,
+      baud_rate
+    );
+}
 
 void App::handle_input()
 {
@@ -161,48 +489,110 @@ void App::run()
 {
     ImVec4 clear_color = ImVec4(0.45, 0.55, 0.60, 1.00);
 
+    const auto frame_interval =
+      options.max_fps > 0
+        ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::seconds(1)
+          ) / options.max_fps
+        : std::chrono::steady_clock::duration::zero();
+    auto last_frame   = std::chrono::steady_clock::now();
+    auto extra_frames = 0;
+
+    SESAMO_TRACE_THREAD("ui");
     while (!quit) {
         if (glfwWindowShouldClose(window) == 1) { quit = true; }
 
-        glfwPollEvents();
-        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED) != 0) { continue; }
+        SESAMO_TRACE_SCOPE("ui.frame");
+
+        // Never draw faster than --max-fps, whatever arrives meanwhile is
+        // picked up by the next frame.
+        {
+            SESAMO_TRACE_SCOPE("ui.wait");
+            std::this_thread::sleep_until(last_frame + frame_interval);
+
+            // Block until there is input, serial data or the idle timeout,
+            // then draw a couple more frames so ImGui can settle what the
+            // input changed (hover, released buttons, ...).
+            if (extra_frames > 0) {
+                glfwPollEvents();
+                --extra_frames;
+            } else {
+                glfwWaitEventsTimeout(IDLE_REDRAW_INTERVAL);
+                extra_frames = EXTRA_FRAMES;
+            }
+        }
+        last_frame = std::chrono::steady_clock::now();
 
-        handle_input();
+        refresh_ttys();
+        // A minimized window takes nothing, every port's Backpressure
+        // decides what happens to its bytes until it is restored.
+        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED) != 0) { continue; }
+        ingest_ports();
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        {
+            SESAMO_TRACE_SCOPE("ui.input");
+            const FrameStats::Scope scope(
+              frame_stats, FrameStats::Stage::Input
+            );
+            handle_input();
+        }
 
-        // Main window
         {
-            ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 0.0);
-            ImGui::SetNextWindowPos(ImVec2(0.0, 0.0));
-            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
-            ImGui::Begin(
-              "sesamo",
-              nullptr,
-              ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoResize
+            SESAMO_TRACE_SCOPE("ui.layout");
+            const FrameStats::Scope scope(
+              frame_stats, FrameStats::Stage::Layout
             );
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
 
-            // Menu
+            // Main window
             {
-                render_control_buttons();
-                ImGui::SameLine();
-                render_tty_device_combo_box();
-                ImGui::SameLine();
-                render_baud_rate_combo_box();
-                ImGui::SameLine();
-                render_connection_status();
+                ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 0.0);
+                ImGui::SetNextWindowPos(ImVec2(0.0, 0.0));
+                ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+                ImGui::Begin(
+                  "sesamo",
+                  nullptr,
+                  ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoResize
+                );
+
+                // Menu
+                {
+                    render_control_buttons();
+                    ImGui::SameLine();
+                    render_tty_device_combo_box();
+                    ImGui::SameLine();
+                    if (!available_ttys.empty()
+                        && Synthetic::parse(available_ttys[selected_tty].path
+                        )) {
+                        render_synthetic_rate_combo_box();
+                    } else {
+                        render_baud_rate_combo_box();
+                    }
+                    ImGui::SameLine();
+                    render_backpressure_combo_box();
+                    ImGui::SameLine();
+                    render_connection_status();
+                }
+
+                // Read Area
+                render_serial_output();
+
+                ImGui::End();
+                ImGui::PopStyleVar(1);
             }
 
-            // Read Area
-            render_serial_output();
-
-            ImGui::End();
-            ImGui::PopStyleVar(1);
+            if (frame_stats.enabled()) { render_performance_overlay(); }
         }
 
-        ImGui::Render();
+        {
+            SESAMO_TRACE_SCOPE("ui.render");
+            const FrameStats::Scope scope(
+              frame_stats, FrameStats::Stage::Render
+            );
+            ImGui::Render();
+        }
         int display_w = 0;
         int display_h = 0;
         glfwGetFramebufferSize(window, &display_w, &display_h);
@@ -214,16 +604,42 @@ void App::run()
           clear_color.w
         );
         glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(window);
+        {
+            SESAMO_TRACE_SCOPE("ui.draw");
+            const FrameStats::Scope scope(frame_stats, FrameStats::Stage::Draw);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        {
+            SESAMO_TRACE_SCOPE("ui.swap");
+            glfwSwapBuffers(window);
+        }
+
+        if (frame_stats.enabled()) {
+            std::size_t memory = 0;
+            for (const auto &port : ports) {
+                memory += port.scrollback->memory_usage()
+                          + port.timeline.memory_usage();
+            }
+            frame_stats.end_frame(memory, reactor->stats().wakeups);
+        }
     }
+
+    if (!options.trace.empty()) { dump_trace(); }
 }
 
 void App::render_control_buttons()
 {
+    const auto *port = active_port();
+
     // Connect button
     {
-        ImGui::BeginDisabled(connected);
+        const auto already_connected =
+          !available_ttys.empty()
+          && std::ranges::any_of(ports, [this](const Port &other) {
+                 return other.connected
+                        && other.path == available_ttys[selected_tty].path;
+             });
+        ImGui::BeginDisabled(already_connected);
         if (ImGui::Button("Connect [Enter]")) { connect_to_serial(); }
         ImGui::EndDisabled();
     }
@@ -232,10 +648,8 @@ void App::render_control_buttons()
 
     // Disconnect button
     {
-        ImGui::BeginDisabled(!connected);
-        if (ImGui::Button("Disconnect [Q]") && serial) {
-            disconnect_from_serial();
-        }
+        ImGui::BeginDisabled(port == nullptr || !port->connected);
+        if (ImGui::Button("Disconnect [Q]")) { disconnect_from_serial(); }
         ImGui::EndDisabled();
     }
 
@@ -247,6 +661,52 @@ void App::render_control_buttons()
             clear_received_messages_buffer();
         }
     }
+
+    ImGui::SameLine();
+
+    // Timestamp column
+    {
+        ImGui::Checkbox("Timestamps", &show_timestamps);
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!show_timestamps);
+        if (ImGui::Checkbox("Wall clock", &wall_clock_timestamps)) {
+            for (auto &other : ports) {
+                if (other.connected) {
+                    other.serial->capture_realtime(wall_clock_timestamps);
+                }
+            }
+        }
+        ImGui::EndDisabled();
+    }
+
+    ImGui::SameLine();
+
+    // Reopen ports whose device went away, say on a reset
+    {
+        if (ImGui::Checkbox("Reconnect", &auto_reconnect)) {
+            for (auto &other : ports) {
+                if (other.connected) {
+                    other.serial->reconnect(auto_reconnect);
+                }
+            }
+        }
+    }
+
+    ImGui::SameLine();
+
+    // Performance overlay
+    {
+        bool overlay = frame_stats.enabled();
+        if (ImGui::Checkbox("Perf", &overlay)) {
+            frame_stats.set_enabled(overlay);
+        }
+    }
+
+    // Trace dump, only with --trace
+    if (!options.trace.empty()) {
+        ImGui::SameLine();
+        if (ImGui::Button("Dump trace")) { dump_trace(); }
+    }
 }
 
 void App::render_tty_device_combo_box()
@@ -257,20 +717,26 @@ void App::render_tty_device_combo_box()
 
     const auto max = std::ranges::max_element(
       available_ttys,
-      [](const auto &rhs, const auto &lhs) { return lhs.size() > rhs.size(); }
+      [](const auto &rhs, const auto &lhs) {
+          return lhs.label.size() > rhs.label.size();
+      }
     );
 
     assert(max != available_ttys.end());
-    ImGui::PushItemWidth(ImGui::CalcTextSize(max->c_str()).x + 20.0F);
+    ImGui::PushItemWidth(ImGui::CalcTextSize(max->label.c_str()).x + 20.0F);
 
     if (ImGui::BeginCombo(
-          "##SelectTty", available_ttys[selected_tty].c_str()
+          "##SelectTty", available_ttys[selected_tty].label.c_str()
         )) {
         for (size_t i = 0; i < available_ttys.size(); ++i) {
-            const bool selected = selected_tty == i;
-            if (ImGui::Selectable(available_ttys[i].c_str(), selected)) {
+            const auto &tty      = available_ttys[i];
+            const bool  selected = selected_tty == i;
+            if (ImGui::Selectable(tty.label.c_str(), selected)) {
                 selected_tty = i;
             }
+            if (!tty.details.empty()) {
+                ImGui::SetItemTooltip("%s", tty.details.c_str());
+            }
 
             if (selected) { ImGui::SetItemDefaultFocus(); }
         }
@@ -287,21 +753,73 @@ void App::render_baud_rate_combo_box()
     ImGui::TextUnformatted("Baud Rate: ");
     ImGui::SameLine();
 
-    auto items =
-      BAUD_RATES
-      | std::views::transform([](const auto &pair) { return pair.first; })
-      | std::ranges::to<std::vector>();
-    assert(items.size() > 0);
+    assert(BAUD_RATES.size() > 0);
+
+    // NOLINTNEXTLINE
+    ImGui::PushItemWidth(
+      ImGui::CalcTextSize(BAUD_RATES.back().first.data()).x + 35.0F
+    );
+    if (ImGui::BeginCombo(
+          "##SelectBaudRate", selected_baud_rate_label.data()
+        )) {
+        // Free-form entry for rates that are not in the list, e.g. the odd
+        // divisors USB bridges support. Applied on Enter.
+        if (ImGui::InputText(
+              "##CustomBaudRate",
+              custom_baud_rate.data(),
+              custom_baud_rate.size(),
+              ImGuiInputTextFlags_CharsDecimal
+                | ImGuiInputTextFlags_EnterReturnsTrue
+            )) {
+            std::uint32_t baud_rate = 0;
+            const auto   *end =
+              custom_baud_rate.data() + std::strlen(custom_baud_rate.data());
+            const auto [_, error] =
+              std::from_chars(custom_baud_rate.data(), end, baud_rate);
+            if (error == std::errc{} && baud_rate > 0) {
+                select_baud_rate(baud_rate);
+                ImGui::CloseCurrentPopup();
+            }
+        }
+
+        for (const auto &[label, baud_rate] : BAUD_RATES) {
+            const bool selected = selected_baud_rate == baud_rate;
+            // NOLINTNEXTLINE
+            if (ImGui::Selectable(label.data(), selected)) {
+                select_baud_rate(baud_rate);
+            }
+
+            if (selected) { ImGui::SetItemDefaultFocus(); }
+        }
+
+        ImGui::EndCombo();
+    }
+
+    ImGui::PopItemWidth();
+}
+
+void App::render_synthetic_rate_combo_box()
+{
+    // NOLINTNEXTLINE
+    ImGui::TextUnformatted("Rate: ");
+    ImGui::SameLine();
+
+    const auto current = std::ranges::find(
+      SYNTHETIC_RATES,
+      selected_synthetic_rate,
+      &std::pair<std::string_view, std::uint64_t>::second
+    );
+    assert(current != SYNTHETIC_RATES.end());
 
     // NOLINTNEXTLINE
-    ImGui::PushItemWidth(ImGui::CalcTextSize(items.back().data()).x + 35.0F);
+    ImGui::PushItemWidth(ImGui::CalcTextSize("100 MB/s").x + 35.0F);
     // NOLINTNEXTLINE
-    if (ImGui::BeginCombo("##SelectBaudRate", selected_baud_rate.data())) {
-        for (const auto &item : items) {
-            const bool selected = selected_baud_rate == item;
+    if (ImGui::BeginCombo("##SelectSyntheticRate", current->first.data())) {
+        for (const auto &[label, rate] : SYNTHETIC_RATES) {
+            const bool selected = selected_synthetic_rate == rate;
             // NOLINTNEXTLINE
-            if (ImGui::Selectable(item.data(), selected)) {
-                selected_baud_rate = item;
+            if (ImGui::Selectable(label.data(), selected)) {
+                selected_synthetic_rate = rate;
             }
 
             if (selected) { ImGui::SetItemDefaultFocus(); }
@@ -313,27 +831,214 @@ void App::render_baud_rate_combo_box()
     ImGui::PopItemWidth();
 }
 
-void App::render_serial_output()
+void App::render_backpressure_combo_box()
 {
-    ImGui::BeginChild("##ReadArea", ImVec2(READ_AREA_WIDTH, READ_AREA_HEIGHT));
+    // NOLINTNEXTLINE
+    ImGui::TextUnformatted("On overflow: ");
+    ImGui::SameLine();
+
+    // NOLINTNEXTLINE
+    ImGui::PushItemWidth(ImGui::CalcTextSize("drop-newest").x + 35.0F);
+    if (ImGui::BeginCombo(
+          "##SelectBackpressure",
+          Serial::describe(selected_backpressure).data()
+        )) {
+        for (const auto policy : BACKPRESSURES) {
+            const bool selected = selected_backpressure == policy;
+            // NOLINTNEXTLINE
+            if (ImGui::Selectable(Serial::describe(policy).data(), selected)) {
+                selected_backpressure = policy;
+            }
+
+            if (selected) { ImGui::SetItemDefaultFocus(); }
+        }
+
+        ImGui::EndCombo();
+    }
+    ImGui::SetItemTooltip(
+      "What a port connected from now on does with what arrives while its "
+      "read buffer is full"
+    );
+
+    ImGui::PopItemWidth();
+}
+
+void App::refresh_ttys()
+{
+    // Nothing to do unless the registry saw a device come or go.
+    const auto generation = devices->generation();
+    if (generation == devices_seen && !available_ttys.empty()) { return; }
+    devices_seen = generation;
+
+    const auto selected = available_ttys.empty()
+                            ? std::string{}
+                            : available_ttys[selected_tty].path;
+
+    available_ttys.clear();
+    for (const auto &device : devices->devices()) {
+        available_ttys.push_back({ .path    = device.path,
+                                   .label   = label(device),
+                                   .details = details(device) });
+    }
+    for (const auto &[name, _] : Synthetic::PATTERNS) {
+        available_ttys.push_back({ .path    = std::string(name),
+                                   .label   = std::string(name),
+                                   .details = {} });
+    }
+
+    // Stay on the same tty while others come and go.
+    const auto kept = std::ranges::find(available_ttys, selected, &Tty::path);
+    selected_tty =
+      kept == available_ttys.end()
+        ? 0
+        : static_cast<std::size_t>(kept - available_ttys.begin());
+}
+
+void App::ingest_ports()
+{
+    reactor->acknowledge_activity();
+
+    SESAMO_TRACE_SCOPE("ui.ingest");
+    const FrameStats::Scope scope(frame_stats, FrameStats::Stage::Drain);
+
+    // Every port is drained each frame, not just the visible one, so
+    // background tabs never overflow their read buffer.
+    const auto *const shown = active_port();
+    for (auto &port : ports) {
+        if (!port.connected) { continue; }
+
+        // Only the selected tab puts its bytes on screen this frame.
+        const auto measured = frame_stats.enabled() && &port == shown;
+
+        port.serial->read_gaps([&port](const Serial::Gap &gap) {
+            port.note(
+              gap.end,
+              std::format(
+                "[reconnected after {:.3f} s]",
+                static_cast<double>(gap.resumed - gap.lost) / 1e9
+              )
+            );
+        });
+        port.serial->read_counters(
+          [&port](const Serial::CounterSample &sample) {
+              const auto increase = sample.counters.since(
+                port.counters.value_or(Serial::LineCounters{})
+              );
+              if (increase.errors() > 0) {
+                  port.note(
+                    sample.end,
+                    std::format("[line errors: {}]", increase.describe_errors())
+                  );
+              }
+              port.counters = sample.counters;
+          }
+        );
+        frame_stats.add_bytes(port.serial->read_all(
+          [this, &port](const std::span<const char> bytes) {
+              SESAMO_TRACE_SCOPE("ui.append");
+              const FrameStats::Scope scope(
+                frame_stats, FrameStats::Stage::Append
+              );
+              port.append(bytes);
+          },
+          [&port](const std::size_t discarded) { port.discard(discarded); }
+        ));
+        // A note nothing was received after yet.
+        port.mark_notes();
+        port.serial->read_arrivals(
+          [this, &port, measured](Timeline::Arrival arrival) {
+              if (measured) { frame_stats.add_arrival(arrival.monotonic); }
+              while (!port.marks.empty()
+                     && arrival.end > port.marks.front().first) {
+                  port.base += port.marks.front().second;
+                  port.marks.pop_front();
+              }
+              arrival.end += port.base;
+              port.timeline.append(arrival);
+          }
+        );
+
+        // The device went away for good, or reconnecting was off.
+        if (!port.serial->is_connected() && !port.serial->is_reconnecting()) {
+            port.serial->close();
+            port.synthetic.reset();
+            port.connected = false;
+        }
 
-    if (connected) {
-        auto message = std::ranges::fold_left(
-          serial->read_all(),
-          std::string{},
-          [](const auto &acc, const auto &elem) { return acc + elem; }
+        // Follow the lines the scrollback evicted to stay within budget.
+        port.timeline.discard_before(port.scrollback->begin());
+    }
+}
+
+void App::render_serial_output()
+{
+    if (ports.empty()) {
+        ImGui::BeginChild(
+          "##ReadArea", ImVec2(READ_AREA_WIDTH, READ_AREA_HEIGHT)
         );
+        ImGui::EndChild();
+        return;
+    }
 
-        if (!message.empty()) { received_messages_buffer.push_back(message); }
+    std::optional<std::size_t> closed;
+    if (ImGui::BeginTabBar(
+          "##Ports",
+          ImGuiTabBarFlags_Reorderable | ImGuiTabBarFlags_FittingPolicyScroll
+        )) {
+        for (std::size_t i = 0; i < ports.size(); ++i) {
+            auto &port  = ports[i];
+            bool  open  = true;
+            auto  flags = ImGuiTabItemFlags_None;
+            if (focus_port == i) { flags = ImGuiTabItemFlags_SetSelected; }
+
+            if (ImGui::BeginTabItem(port.path.c_str(), &open, flags)) {
+                selected_port = i;
+                render_port_output(port);
+                ImGui::EndTabItem();
+            }
 
-        if (received_messages_buffer.size() > RECEIVE_MESSAGE_CAPACITY) {
-            received_messages_buffer.clear();
+            if (!open) { closed = i; }
         }
+        ImGui::EndTabBar();
     }
+    focus_port.reset();
+
+    if (closed) { close_port(*closed); }
+}
+
+void App::render_port_output(const Port &port) const
+{
+    ImGui::BeginChild("##ReadArea", ImVec2(READ_AREA_WIDTH, READ_AREA_HEIGHT));
+
+    // Only the lines in view are laid out, and only their timestamps get
+    // looked up and formatted.
+    std::array<char, TIMESTAMP_SIZE> timestamp{};
+    ImGuiListClipper                 clipper;
+    clipper.Begin(static_cast<int>(port.scrollback->line_count()));
+    while (clipper.Step()) {
+        for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const auto index = static_cast<std::size_t>(i);
+
+            if (show_timestamps) {
+                const auto text = format_timestamp(
+                  timestamp,
+                  port.timeline.at(port.scrollback->line_offset(index)),
+                  port.connected_at,
+                  wall_clock_timestamps
+                );
+                ImGui::PushStyleColor(
+                  ImGuiCol_Text, ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled)
+                );
+                ImGui::TextUnformatted(text.data(), text.data() + text.size());
+                ImGui::PopStyleColor();
+                ImGui::SameLine(0.0F, 0.0F);
+            }
 
-    std::string output;
-    for (const auto &line : received_messages_buffer) { output += line; }
-    ImGui::TextUnformatted(output.c_str());
+            const auto line = port.scrollback->line(index);
+            ImGui::TextUnformatted(line.data(), line.data() + line.size());
+        }
+    }
+    clipper.End();
 
     if (ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
         ImGui::SetScrollHereY(1.0);
@@ -343,12 +1048,20 @@ void App::render_serial_output()
 
 void App::render_connection_status() const
 {
-    const char *text      = connected ? "Connected" : "Disconnected";
+    const auto *port      = active_port();
+    const auto  connected = port != nullptr && port->connected;
+    const auto  reconnecting =
+      connected && port->serial->is_reconnecting();
+
+    const char *text      = reconnecting ? "Reconnecting"
+                            : connected  ? "Connected"
+                                         : "Disconnected";
     ImVec2      text_pos  = ImGui::GetCursorScreenPos();
     ImVec2      text_size = ImGui::CalcTextSize(text);
 
-    ImU32 bg_color =
-      connected ? IM_COL32(0, 255, 0, 150) : IM_COL32(255, 0, 0, 150);
+    ImU32 bg_color = reconnecting ? IM_COL32(255, 160, 0, 150)
+                     : connected  ? IM_COL32(0, 255, 0, 150)
+                                  : IM_COL32(255, 0, 0, 150);
     ImGui::GetWindowDrawList()->AddRectFilled(
       text_pos,
       ImVec2(text_pos.x + text_size.x, (text_pos.y * 2) + text_size.y),
@@ -356,4 +1069,124 @@ void App::render_connection_status() const
     );
 
     ImGui::TextUnformatted(text);
+
+    if (connected && port->serial->dropped_bytes() > 0) {
+        ImGui::SameLine();
+        // NOLINTNEXTLINE
+        ImGui::TextColored(
+          ImVec4(1.0, 0.4, 0.4, 1.0),
+          "Dropped %llu bytes (%s)",
+          static_cast<unsigned long long>(port->serial->dropped_bytes()),
+          Serial::describe(port->serial->backpressure()).data()
+        );
+    }
+
+    // Blocked or spilling and not caught up yet.
+    if (connected && port->serial->is_behind()) {
+        const auto backlog = port->serial->stats().backlog;
+        ImGui::SameLine();
+        if (backlog > 0) {
+            // NOLINTNEXTLINE
+            ImGui::TextColored(
+              ImVec4(1.0, 0.65, 0.0, 1.0),
+              "%llu KiB waiting",
+              static_cast<unsigned long long>(backlog / 1024)
+            );
+        } else {
+            // NOLINTNEXTLINE
+            ImGui::TextColored(ImVec4(1.0, 0.65, 0.0, 1.0), "Reading paused");
+        }
+    }
+
+    // What the driver counted, errors in red.
+    if (connected && port->counters) {
+        const auto &counters = *port->counters;
+        const auto  color =
+          counters.errors() > 0
+            ? ImVec4(1.0, 0.4, 0.4, 1.0)
+            : ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled);
+        ImGui::SameLine();
+        // NOLINTNEXTLINE
+        ImGui::TextColored(
+          color,
+          "rx %llu tx %llu, overrun %llu framing %llu parity %llu break %llu "
+          "buffer overrun %llu",
+          static_cast<unsigned long long>(counters.rx),
+          static_cast<unsigned long long>(counters.tx),
+          static_cast<unsigned long long>(counters.overrun),
+          static_cast<unsigned long long>(counters.frame),
+          static_cast<unsigned long long>(counters.parity),
+          static_cast<unsigned long long>(counters.brk),
+          static_cast<unsigned long long>(counters.buffer_overrun)
+        );
+    }
+
+    if (connected && port->serial->stats().reconnects > 0) {
+        const auto stats = port->serial->stats();
+        ImGui::SameLine();
+        // NOLINTNEXTLINE
+        ImGui::TextDisabled(
+          "Reconnected %llu times, resumed within %.1f ms",
+          static_cast<unsigned long long>(stats.reconnects),
+          std::chrono::duration<double, std::milli>(stats.resume_lag).count()
+        );
+    }
+
+    // Bytes the generator had to skip because the pty was full, i.e. the
+    // reactor did not keep up with the rate.
+    if (connected && port->synthetic && port->synthetic->stats().overrun > 0) {
+        ImGui::SameLine();
+        // NOLINTNEXTLINE
+        ImGui::TextColored(
+          ImVec4(1.0, 0.4, 0.4, 1.0),
+          "Overrun %llu bytes",
+          static_cast<unsigned long long>(port->synthetic->stats().overrun)
+        );
+    }
+}
+
+void App::render_performance_overlay()
+{
+    constexpr float MARGIN = 10.0F;
+
+    const auto &display = ImGui::GetIO().DisplaySize;
+    ImGui::SetNextWindowPos(
+      ImVec2(display.x - MARGIN, display.y - MARGIN),
+      ImGuiCond_Always,
+      ImVec2(1.0, 1.0)
+    );
+    // NOLINTNEXTLINE
+    ImGui::SetNextWindowBgAlpha(0.85F);
+    if (!ImGui::Begin(
+          "Performance",
+          nullptr,
+          ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize
+            | ImGuiWindowFlags_NoSavedSettings
+            | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav
+        )) {
+        ImGui::End();
+        return;
+    }
+
+    plot_series("frame", frame_stats.total(), "ms");
+    for (std::size_t i = 0; i < FrameStats::STAGE_COUNT; ++i) {
+        const auto stage = static_cast<FrameStats::Stage>(i);
+        plot_series(FrameStats::name(stage), frame_stats.stage(stage), "ms");
+    }
+    plot_series("ingested", frame_stats.bytes(), "B/frame");
+    plot_series("scrollback", frame_stats.memory(), "MiB");
+    plot_series("reader wakeups", frame_stats.wakeups_per_second(), "/s");
+    plot_series("byte to pixel", frame_stats.latency(), "ms");
+    plot_latencies(frame_stats.latencies(), frame_stats.latency_buckets());
+    if (!reader_tuning.empty()) {
+        // NOLINTNEXTLINE
+        ImGui::Text("reader thread: %s", reader_tuning.c_str());
+    }
+
+    // NOLINTNEXTLINE
+    if (ImGui::SmallButton("Reset latencies")) {
+        frame_stats.reset_latencies();
+    }
+
+    ImGui::End();
 }
@@ -1,20 +1,51 @@
 #ifndef SESAMO_APPLICATION_HPP
 #define SESAMO_APPLICATION_HPP
 
+#include <array>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
-#include <termios.h>
-
 #include <GLFW/glfw3.h>
 
+#include "DeviceRegistry.hpp"
+#include "FrameStats.hpp"
+#include "Reactor.hpp"
+#include "Scrollback.hpp"
 #include "Serial.hpp"
+#include "Synthetic.hpp"
+#include "Timeline.hpp"
 
 class [[nodiscard]] App final
 {
   public:
-    [[nodiscard]] static auto spawn() -> std::unique_ptr<App>;
+    constexpr static unsigned DEFAULT_MAX_FPS = 60;
+
+    struct Options
+    {
+        Reactor::Backend reader_backend = Reactor::Backend::Epoll;
+        // Bytes of history kept per port.
+        std::size_t scrollback_capacity = Scrollback::DEFAULT_CAPACITY;
+        // Upper bound on redraws per second on top of vsync, 0 for none.
+        unsigned max_fps = DEFAULT_MAX_FPS;
+        // CPU pinning, SCHED_FIFO and mlock for the reader thread.
+        Reactor::Tuning reader_tuning;
+        // Read buffer size and spill file of every port, and the
+        // backpressure preselected for new ones.
+        Serial::Buffering buffering;
+        // Chrome trace JSON written by "Dump trace" and on exit, empty for
+        // none. Needs a build with SESAMO_TRACE.
+        std::string trace;
+    };
+
+    [[nodiscard]] static auto spawn(const Options &options)
+      -> std::unique_ptr<App>;
 
     void run();
 
@@ -27,19 +58,97 @@ class [[nodiscard]] App final
     App &operator=(App &&) = default;
 
   private:
-    explicit App(GLFWwindow *window);
+    // Every monitored port gets its own tab, all of them are read by the
+    // same reactor thread.
+    struct Port
+    {
+        std::string             path;
+        std::shared_ptr<Serial> serial    = nullptr;
+        bool                    connected = false;
+
+        // Set while connected to one of the "synthetic:" entries, which
+        // `serial` reads through a pty like any other port.
+        std::unique_ptr<Synthetic> synthetic;
+
+        std::unique_ptr<Scrollback> scrollback;
+        Timeline                    timeline;
+
+        // Offsets reported by `serial` start from zero on every connect,
+        // `base` maps them onto this tab's stream.
+        std::uint64_t base         = 0;
+        std::int64_t  connected_at = 0;
+
+        // A line to put into the scrollback once `end` bytes of `serial`
+        // were appended: a reconnect, line errors the driver counted.
+        struct Note
+        {
+            std::uint64_t end = 0;
+            std::string   text;
+        };
+
+        // Notes not in the scrollback yet, ordered by `end`, and marks
+        // (where, by how much) that the timestamps still have to be moved
+        // past. A hole in the stream moves them back, its mark wraps
+        // around.
+        std::deque<Note>                                    notes;
+        std::deque<std::pair<std::uint64_t, std::uint64_t>> marks;
+        // Bytes of `serial` appended so far.
+        std::uint64_t consumed   = 0;
+        bool          line_start = true;
+
+        // Latest line counters, empty while the driver reported none.
+        std::optional<Serial::LineCounters> counters;
+
+        void clear();
+
+        // Appends bytes of `serial` to the scrollback, with the notes that
+        // fall in between on lines of their own.
+        void append(std::span<const char> bytes);
+        // Marks where `serial` gave up `bytes` it had for us.
+        void discard(std::uint64_t bytes);
+        void note(std::uint64_t end, std::string text);
+        void mark_notes();
+    };
+
+    // An entry of the tty combo box.
+    struct Tty
+    {
+        std::string path;
+        std::string label;
+        // Shown on hover, empty for nothing to add.
+        std::string details;
+    };
+
+    explicit App(
+      GLFWwindow                     *window,
+      const Options                  &options,
+      std::shared_ptr<Reactor>        reactor,
+      std::unique_ptr<DeviceRegistry> devices
+    );
+
+    [[nodiscard]] Port *active_port();
+    [[nodiscard]] const Port *active_port() const;
 
     void connect_to_serial();
     void disconnect_from_serial();
+    void close_port(const std::size_t index);
     void clear_received_messages_buffer();
+    void select_baud_rate(const std::uint32_t baud_rate);
+    void dump_trace() const;
 
     void handle_input();
+    void ingest_ports();
+    void refresh_ttys();
 
     void render_control_buttons();
     void render_tty_device_combo_box();
     void render_baud_rate_combo_box();
+    void render_synthetic_rate_combo_box();
+    void render_backpressure_combo_box();
     void render_serial_output();
+    void render_port_output(const Port &port) const;
     void render_connection_status() const;
+    void render_performance_overlay();
 
   private:
     constexpr static auto        WINDOW_WIDTH     = 1920;
@@ -48,30 +157,100 @@ class [[nodiscard]] App final
     constexpr static auto        READ_AREA_HEIGHT = 720;
     constexpr static const char *GLSL_VERSION     = "#version 330";
 
-    constexpr static auto RECEIVE_MESSAGE_CAPACITY = 4096;
+    // Nothing needs redrawing on its own, this is just a safety net.
+    constexpr static double IDLE_REDRAW_INTERVAL = 1.0;
+    constexpr static int    EXTRA_FRAMES         = 2;
+
+    // "hh:mm:ss.uuuuuu " or seconds since connecting, padded to the same
+    // width.
+    constexpr static std::size_t TIMESTAMP_SIZE = 32;
+
+    // Presets for the baud rate combo box, anything else can be typed in.
+    inline static const std::vector<std::pair<std::string_view, std::uint32_t>>
+      BAUD_RATES = { { "0", 0 },
+                     { "50", 50 },
+                     { "75", 75 },
+                     { "110", 110 },
+                     { "134", 134 },
+                     { "150", 150 },
+                     { "200", 200 },
+                     { "300", 300 },
+                     { "600", 600 },
+                     { "1200", 1200 },
+                     { "1800", 1800 },
+                     { "2400", 2400 },
+                     { "4800", 4800 },
+                     { "9600", 9600 },
+                     { "19200", 19200 },
+                     { "38400", 38400 },
+                     { "57600", 57600 },
+                     { "115200", 115200 },
+                     { "230400", 230400 },
+                     { "460800", 460800 },
+                     { "500000", 500000 },
+                     { "576000", 576000 },
+                     { "921600", 921600 },
+                     { "1000000", 1000000 },
+                     { "1152000", 1152000 },
+                     { "1500000", 1500000 },
+                     { "2000000", 2000000 },
+                     { "2500000", 2500000 },
+                     { "3000000", 3000000 },
+                     { "3500000", 3500000 },
+                     { "4000000", 4000000 },
+                     { "6000000", 6000000 },
+                     { "12000000", 12000000 } };
 
-    constexpr static auto TTY_PATH = "/dev/";
+    constexpr static std::size_t BAUD_RATE_INPUT_SIZE = 16;
 
-    inline static const std::vector<std::pair<std::string_view, int>>
-      BAUD_RATES = { { "0", B0 },        { "50", B50 },     { "75", B75 },
-                     { "110", B110 },    { "134", B134 },   { "150", B150 },
-                     { "200", B200 },    { "300", B300 },   { "600", B600 },
-                     { "1200", B1200 },  { "1800", B1800 }, { "2400", B2400 },
-                     { "4800", B4800 },  { "9600", B9600 }, { "19200", B19200 },
-                     { "38400", B38400 } };
+    // Takes the place of the baud rate for the synthetic source.
+    inline static const std::vector<std::pair<std::string_view, std::uint64_t>>
+      SYNTHETIC_RATES = { { "1 KB/s", 1'000 },
+                          { "10 KB/s", 10'000 },
+                          { "100 KB/s", 100'000 },
+                          { "1 MB/s", 1'000'000 },
+                          { "10 MB/s", 10'000'000 },
+                          { "100 MB/s", 100'000'000 },
+                          { "200 MB/s", 200'000'000 } };
+
+    // What a new port does once this side falls behind.
+    constexpr static std::array BACKPRESSURES = {
+        Serial::Backpressure::DropNewest,
+        Serial::Backpressure::DropOldest,
+        Serial::Backpressure::Block,
+        Serial::Backpressure::Spill,
+    };
 
   private:
     GLFWwindow *window = nullptr;
     bool        quit   = false;
+    Options     options;
+
+    std::shared_ptr<Reactor>   reactor;
+    std::vector<Port>          ports;
+    size_t                     selected_port = 0;
+    std::optional<std::size_t> focus_port;
+
+    bool show_timestamps       = false;
+    bool wall_clock_timestamps = false;
+    bool auto_reconnect        = true;
+
+    FrameStats frame_stats;
+    // What of Options::reader_tuning was applied, empty if nothing was asked.
+    std::string reader_tuning;
+
+    std::unique_ptr<DeviceRegistry> devices;
+    std::uint64_t                   devices_seen = 0;
+    std::vector<Tty>                available_ttys;
+    size_t                          selected_tty = 0;
 
-    std::shared_ptr<Serial>  serial    = nullptr;
-    bool                     connected = false;
-    std::vector<std::string> received_messages_buffer;
+    std::uint32_t                          selected_baud_rate = 19200;
+    std::array<char, BAUD_RATE_INPUT_SIZE> selected_baud_rate_label{ "19200" };
+    std::array<char, BAUD_RATE_INPUT_SIZE> custom_baud_rate{};
 
-    std::vector<std::string> available_ttys;
-    size_t                   selected_tty = 0;
+    std::uint64_t selected_synthetic_rate = 1'000'000;
 
-    std::string_view selected_baud_rate = "19200";
+    Serial::Backpressure selected_backpressure;
 };
 
 #endif // SESAMO_APPLICATION_HPP
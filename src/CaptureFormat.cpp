@@ -0,0 +1,49 @@
+#include "CaptureFormat.hpp"
+
+#include <cstddef>
+
+namespace
+{
+
+constexpr auto CRC_TABLE = [] {
+    constexpr std::uint32_t POLYNOMIAL = 0xedb88320;
+
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < table.size(); ++i) {
+        auto value = i;
+        for (auto bit = 0; bit < 8; ++bit) {
+            const auto carry = (value & 1U) != 0;
+            value            = (value >> 1U) ^ (carry ? POLYNOMIAL : 0U);
+        }
+        table[i] = value;
+    }
+    return table;
+}();
+
+} // namespace
+
+namespace capture
+{
+
+std::uint32_t crc32(const std::span<const char> bytes, std::uint32_t crc)
+{
+    crc = ~crc;
+    for (const auto byte : bytes) {
+        crc = CRC_TABLE[(crc ^ static_cast<std::uint8_t>(byte)) & 0xffU]
+              ^ (crc >> 8U);
+    }
+    return ~crc;
+}
+
+std::uint32_t
+  record_crc(const RecordHeader &header, const std::span<const char> payload)
+{
+    // NOLINTNEXTLINE
+    const auto *bytes = reinterpret_cast<const char *>(&header);
+    const auto  crc   = crc32(
+      { bytes + sizeof(header.crc), sizeof(header) - sizeof(header.crc) }
+    );
+    return crc32(payload, crc);
+}
+
+} // namespace capture
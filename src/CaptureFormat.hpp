@@ -0,0 +1,142 @@
+#ifndef SESAMO_CAPTURE_FORMAT_HPP
+#define SESAMO_CAPTURE_FORMAT_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+// On-disk layout of a sesamo capture (.cap), native endianness.
+//
+//   FileHeader
+//   batch: Record(Chunk | Gap | Counters)... Record(Index) Footer
+//   batch: ...
+//
+// Every record is a RecordHeader followed by `size` payload bytes and
+// carries a CRC-32 over both. The writer appends one batch per write(2)
+// and syncs it, so a crash can at worst leave a torn last batch behind,
+// which readers detect and ignore.
+//
+// The Index record closing a batch lists where each of the batch's chunks
+// starts, plus the names of every port seen so far, and points back to the
+// previous batch's Index record. The Footer right after it points at the
+// Index record, so a reader gets from the end of the file to every index
+// without touching chunk data and can then binary search by time or by
+// byte offset.
+//
+// A Gap record has no payload and marks where a port went away and was
+// reconnected later, its chunks go on from the same stream offset.
+//
+// A Counters record carries a port's line counters (Counters below), one
+// is written whenever they changed since the last poll, at most every
+// 100 ms per port.
+namespace capture
+{
+
+constexpr std::array<char, 8> FILE_MAGIC   = { 'S', 'E', 'S', 'A',
+                                               'M', 'O', 'C', 'P' };
+constexpr std::array<char, 8> FOOTER_MAGIC = { 'S', 'E', 'S', 'A',
+                                               'M', 'O', 'I', 'X' };
+constexpr std::uint32_t       VERSION      = 1;
+
+struct FileHeader
+{
+    std::array<char, 8> magic    = FILE_MAGIC;
+    std::uint32_t       version  = VERSION;
+    std::uint32_t       reserved = 0;
+    // When the capture started, CLOCK_REALTIME and CLOCK_MONOTONIC.
+    std::int64_t realtime  = 0;
+    std::int64_t monotonic = 0;
+};
+
+enum class RecordType : std::uint16_t
+{
+    Chunk    = 1,
+    Index    = 2,
+    Gap      = 3,
+    Counters = 4,
+};
+
+enum class Direction : std::uint8_t
+{
+    Receive  = 0,
+    Transmit = 1,
+};
+
+struct RecordHeader
+{
+    // CRC-32 of the rest of the header and the payload.
+    std::uint32_t               crc       = 0;
+    std::uint32_t               size      = 0;
+    RecordType                  type      = RecordType::Chunk;
+    std::uint16_t               port      = 0;
+    Direction                   direction = Direction::Receive;
+    std::array<std::uint8_t, 3> reserved{};
+    // Chunk: offset of its first byte in the port's stream, a jump means
+    // bytes were lost. Gap: offset the stream resumes at. Counters: stream
+    // offset when they were read. Index: file offset of the previous Index
+    // record, or 0 for the first one.
+    std::uint64_t offset = 0;
+    // Chunk: when the read returned. Gap: when the port went away.
+    // Counters: when they were read. Index: time of its first entry.
+    std::int64_t monotonic = 0;
+    std::int64_t realtime  = 0;
+};
+
+// Index payload: IndexHeader, `entries` IndexEntry, then `names_size` bytes
+// of port names, each a PortName followed by its characters.
+struct IndexHeader
+{
+    std::uint32_t entries    = 0;
+    std::uint32_t names_size = 0;
+};
+
+struct IndexEntry
+{
+    std::uint64_t file_offset = 0;
+    // Position of the chunk's first byte among all captured bytes.
+    std::uint64_t capture_offset = 0;
+    std::int64_t  monotonic      = 0;
+};
+
+struct PortName
+{
+    std::uint16_t port   = 0;
+    std::uint16_t length = 0;
+};
+
+// Counters payload: totals since the port was opened, as the tty driver
+// reports them through TIOCGICOUNT.
+struct Counters
+{
+    std::uint64_t rx             = 0;
+    std::uint64_t tx             = 0;
+    std::uint64_t overrun        = 0;
+    std::uint64_t frame          = 0;
+    std::uint64_t parity         = 0;
+    std::uint64_t brk            = 0;
+    std::uint64_t buffer_overrun = 0;
+};
+
+struct Footer
+{
+    std::array<char, 8> magic        = FOOTER_MAGIC;
+    std::uint64_t       index_offset = 0;
+};
+
+static_assert(sizeof(FileHeader) == 32);
+static_assert(sizeof(RecordHeader) == 40);
+static_assert(sizeof(IndexEntry) == 24);
+static_assert(sizeof(Counters) == 56);
+static_assert(sizeof(Footer) == 16);
+
+// CRC-32 (IEEE 802.3) of `bytes`, continuing from `crc`.
+[[nodiscard]] std::uint32_t
+  crc32(std::span<const char> bytes, std::uint32_t crc = 0);
+
+// The CRC a RecordHeader has to carry for `payload`.
+[[nodiscard]] std::uint32_t
+  record_crc(const RecordHeader &header, std::span<const char> payload);
+
+} // namespace capture
+
+#endif // SESAMO_CAPTURE_FORMAT_HPP
@@ -0,0 +1,415 @@
+#include "CaptureReader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <print>
+
+namespace
+{
+
+template <typename Record>
+[[nodiscard]] Record read_as(const std::span<const char> bytes)
+{
+    Record record{};
+    std::memcpy(&record, bytes.data(), sizeof(Record));
+    return record;
+}
+
+} // namespace
+
+auto CaptureReader::open(const std::filesystem::path &path)
+  -> std::unique_ptr<CaptureReader>
+{
+    // NOLINTNEXTLINE
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to open capture {}: {}\n",
+          path.string(),
+          strerror(errno)
+        );
+        return nullptr;
+    }
+
+    struct stat status{};
+    if (fstat(fd, &status) != 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to stat capture {}: {}\n",
+          path.string(),
+          strerror(errno)
+        );
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto reader = std::unique_ptr<CaptureReader>(
+      new CaptureReader(fd, static_cast<std::uint64_t>(status.st_size))
+    );
+
+    const auto header = reader->fetch(0, sizeof(capture::FileHeader));
+    if (header) {
+        reader->file_header = read_as<capture::FileHeader>(*header);
+    }
+    if (!header || reader->file_header.magic != capture::FILE_MAGIC
+        || reader->file_header.version != capture::VERSION) {
+        std::print(
+          stderr, "[ERROR] {} is not a sesamo capture\n", path.string()
+        );
+        return nullptr;
+    }
+
+    if (!reader->load_from_footer()) {
+        reader->batches.clear();
+        reader->names.clear();
+        reader->total = 0;
+        reader->load_by_scanning();
+    }
+
+    if (reader->recovered()) {
+        std::print(
+          stderr,
+          "[WARNING] {} ends in a torn batch, ignoring its last {} bytes\n",
+          path.string(),
+          reader->size - reader->end
+        );
+    }
+
+    reader->rewind();
+    return reader;
+}
+
+CaptureReader::CaptureReader(int fd, std::uint64_t size)
+  : fd(fd),
+    size(size),
+    end(sizeof(capture::FileHeader))
+{}
+
+CaptureReader::~CaptureReader() { ::close(fd); }
+
+std::vector<std::uint16_t> CaptureReader::ports() const
+{
+    std::vector<std::uint16_t> ids;
+    ids.reserve(names.size());
+    for (const auto &[port, _] : names) { ids.push_back(port); }
+    std::ranges::sort(ids);
+    return ids;
+}
+
+std::string_view CaptureReader::port_name(const std::uint16_t port) const
+{
+    const auto name = names.find(port);
+    return name == names.end() ? std::string_view{} : name->second;
+}
+
+auto CaptureReader::next() -> std::optional<Chunk>
+{
+    while (position < end) {
+        const auto record = record_at(position, WINDOW_SIZE);
+        if (!record) {
+            position = end;
+            return std::nullopt;
+        }
+
+        const auto &header = record->header;
+        position += sizeof(header) + header.size;
+        if (header.type == capture::RecordType::Index) {
+            position += sizeof(capture::Footer);
+            continue;
+        }
+        if (header.type != capture::RecordType::Chunk) { continue; }
+
+        Chunk chunk{
+            .port           = header.port,
+            .direction      = header.direction,
+            .offset         = header.offset,
+            .capture_offset = next_capture_at,
+            .monotonic      = header.monotonic,
+            .realtime       = header.realtime,
+            .bytes          = record->payload,
+        };
+        next_capture_at += header.size;
+        return chunk;
+    }
+
+    return std::nullopt;
+}
+
+void CaptureReader::rewind()
+{
+    position        = sizeof(capture::FileHeader);
+    next_capture_at = 0;
+}
+
+bool CaptureReader::seek_time(const std::int64_t monotonic)
+{
+    // The first batch starting after `monotonic`, the chunk we look for is
+    // either late in the batch before it or its very first one.
+    const auto after = std::ranges::upper_bound(
+      batches, monotonic, {}, [](const Batch &batch) {
+          return batch.first.monotonic;
+      }
+    );
+    const auto batch = static_cast<std::size_t>(after - batches.begin());
+
+    if (batch > 0) {
+        const auto index = index_at(batches[batch - 1].index_offset);
+        if (index) {
+            const auto entry = std::ranges::lower_bound(
+              index->entries, monotonic, {}, &capture::IndexEntry::monotonic
+            );
+            if (entry != index->entries.end()) {
+                position        = entry->file_offset;
+                next_capture_at = entry->capture_offset;
+                return true;
+            }
+        }
+    }
+
+    if (batch == batches.size()) {
+        position = end;
+        return false;
+    }
+    seek(batch, 0);
+    return true;
+}
+
+bool CaptureReader::seek_offset(const std::uint64_t capture_offset)
+{
+    if (capture_offset >= total) {
+        position = end;
+        return false;
+    }
+
+    const auto after = std::ranges::upper_bound(
+      batches, capture_offset, {}, [](const Batch &batch) {
+          return batch.first.capture_offset;
+      }
+    );
+    const auto batch = static_cast<std::size_t>(after - batches.begin()) - 1;
+
+    const auto index = index_at(batches[batch].index_offset);
+    if (!index) {
+        position = end;
+        return false;
+    }
+    const auto entry = std::ranges::upper_bound(
+      index->entries, capture_offset, {}, &capture::IndexEntry::capture_offset
+    );
+    seek(batch, static_cast<std::size_t>(entry - index->entries.begin()) - 1);
+    return true;
+}
+
+void CaptureReader::seek(const std::size_t batch, const std::size_t entry)
+{
+    auto target = batches[batch].first;
+    if (entry > 0) {
+        const auto index = index_at(batches[batch].index_offset);
+        if (!index || entry >= index->entries.size()) {
+            position = end;
+            return;
+        }
+        target = index->entries[entry];
+    }
+
+    position        = target.file_offset;
+    next_capture_at = target.capture_offset;
+}
+
+auto CaptureReader::fetch(
+  const std::uint64_t offset,
+  const std::size_t   length,
+  const std::size_t   ahead
+) -> std::optional<std::span<const char>>
+{
+    if (offset > size || length > size - offset) { return std::nullopt; }
+
+    if (offset < window_offset
+        || offset + length > window_offset + window.size()) {
+        const auto wanted = std::min<std::uint64_t>(
+          std::max(length, ahead), size - offset
+        );
+        window.resize(static_cast<std::size_t>(wanted));
+        window_offset = offset;
+
+        std::size_t filled = 0;
+        while (filled < window.size()) {
+            const auto bytes = pread(
+              fd,
+              window.data() + filled,
+              window.size() - filled,
+              static_cast<off_t>(offset + filled)
+            );
+            if (bytes < 0 && errno == EINTR) { continue; }
+            if (bytes <= 0) { break; }
+            filled += static_cast<std::size_t>(bytes);
+        }
+        window.resize(filled);
+        if (filled < length) {
+            std::print(
+              stderr, "[ERROR] failed to read capture: {}\n", strerror(errno)
+            );
+            return std::nullopt;
+        }
+    }
+
+    return std::span<const char>(window).subspan(
+      static_cast<std::size_t>(offset - window_offset), length
+    );
+}
+
+auto CaptureReader::record_at(
+  const std::uint64_t offset,
+  const std::size_t   ahead
+) -> std::optional<Record>
+{
+    const auto raw = fetch(offset, sizeof(capture::RecordHeader), ahead);
+    if (!raw) { return std::nullopt; }
+    const auto header = read_as<capture::RecordHeader>(*raw);
+
+    const auto record =
+      fetch(offset, sizeof(capture::RecordHeader) + header.size, ahead);
+    if (!record) { return std::nullopt; }
+    const auto payload = record->subspan(sizeof(capture::RecordHeader));
+    if (capture::record_crc(header, payload) != header.crc) {
+        return std::nullopt;
+    }
+
+    return Record{ .header = header, .payload = payload };
+}
+
+auto CaptureReader::index_at(const std::uint64_t offset) -> std::optional<Index>
+{
+    const auto record = record_at(offset);
+    if (!record || record->header.type != capture::RecordType::Index
+        || record->payload.size() < sizeof(capture::IndexHeader)) {
+        return std::nullopt;
+    }
+
+    const auto header  = read_as<capture::IndexHeader>(record->payload);
+    const auto entries = record->payload.subspan(sizeof(header));
+    if (entries.size()
+        != (std::size_t{ header.entries } * sizeof(capture::IndexEntry))
+             + header.names_size) {
+        return std::nullopt;
+    }
+
+    Index index{ .header = record->header, .entries = {}, .names = {} };
+    index.entries.resize(header.entries);
+    std::memcpy(
+      index.entries.data(),
+      entries.data(),
+      index.entries.size() * sizeof(capture::IndexEntry)
+    );
+    index.names =
+      entries.subspan(index.entries.size() * sizeof(capture::IndexEntry));
+    return index;
+}
+
+bool CaptureReader::load_from_footer()
+{
+    if (size < sizeof(capture::FileHeader) + sizeof(capture::Footer)) {
+        return false;
+    }
+
+    const auto raw =
+      fetch(size - sizeof(capture::Footer), sizeof(capture::Footer));
+    if (!raw) { return false; }
+    const auto footer = read_as<capture::Footer>(*raw);
+    if (footer.magic != capture::FOOTER_MAGIC) { return false; }
+
+    // Walk the chain from the newest index back to the first one, offsets
+    // have to shrink on every step or the chain is broken.
+    auto offset = footer.index_offset;
+    while (true) {
+        if (offset < sizeof(capture::FileHeader) || offset >= size) {
+            return false;
+        }
+
+        const auto index = index_at(offset);
+        if (!index || index->entries.empty()) { return false; }
+        if (batches.empty()) { load_names(index->names); }
+        add_batch(offset, *index);
+
+        const auto previous = index->header.offset;
+        if (previous == 0) { break; }
+        if (previous >= offset) { return false; }
+        offset = previous;
+    }
+
+    std::ranges::reverse(batches);
+    end = size;
+    return true;
+}
+
+void CaptureReader::load_by_scanning()
+{
+    auto offset = std::uint64_t{ sizeof(capture::FileHeader) };
+    while (offset < size) {
+        const auto record = record_at(offset, WINDOW_SIZE);
+        if (!record) { break; }
+
+        const auto after = offset + sizeof(capture::RecordHeader)
+                           + record->header.size;
+        if (record->header.type != capture::RecordType::Index) {
+            offset = after;
+            continue;
+        }
+
+        const auto index = index_at(offset);
+        if (!index || index->entries.empty()) { break; }
+        load_names(index->names);
+
+        const auto raw = fetch(after, sizeof(capture::Footer), WINDOW_SIZE);
+        if (!raw) { break; }
+        const auto footer = read_as<capture::Footer>(*raw);
+        if (footer.magic != capture::FOOTER_MAGIC
+            || footer.index_offset != offset) {
+            break;
+        }
+
+        add_batch(offset, *index);
+        offset = after + sizeof(capture::Footer);
+        end    = offset;
+    }
+}
+
+void CaptureReader::load_names(std::span<const char> table)
+{
+    names.clear();
+    while (table.size() >= sizeof(capture::PortName)) {
+        const auto name = read_as<capture::PortName>(table);
+        table           = table.subspan(sizeof(name));
+        if (table.size() < name.length) { break; }
+
+        names[name.port] = std::string(table.data(), name.length);
+        table            = table.subspan(name.length);
+    }
+}
+
+void CaptureReader::add_batch(const std::uint64_t offset, const Index &index)
+{
+    batches.push_back({ .index_offset = offset,
+                        .entries      = static_cast<std::uint32_t>(
+                          index.entries.size()
+                        ),
+                        .first        = index.entries.front() });
+
+    // Only chunks add to the captured bytes, the batch may well end with a
+    // counters record.
+    const auto &last   = index.entries.back();
+    auto        ending = last.capture_offset;
+    const auto  raw    = fetch(last.file_offset, sizeof(capture::RecordHeader));
+    if (raw) {
+        const auto header = read_as<capture::RecordHeader>(*raw);
+        if (header.type == capture::RecordType::Chunk) {
+            ending += header.size;
+        }
+    }
+    total = std::max(total, ending);
+}
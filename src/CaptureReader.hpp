@@ -0,0 +1,148 @@
+#ifndef SESAMO_CAPTURE_READER_HPP
+#define SESAMO_CAPTURE_READER_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "CaptureFormat.hpp"
+
+// Reads a capture file written by CaptureWriter.
+//
+// Opening one only touches the index records: the footer at the end of the
+// file leads to the newest index and every index to the one before it. A
+// file whose tail is torn, say because the writer crashed mid-batch, is
+// scanned from the start instead and cut off after the last intact batch.
+// Seeking binary searches the batches, then the entries of one batch, so it
+// reads a single index no matter how long the capture is.
+class [[nodiscard]] CaptureReader final
+{
+  public:
+    struct Chunk
+    {
+        std::uint16_t      port      = 0;
+        capture::Direction direction = capture::Direction::Receive;
+        // Offset of the first byte in the port's stream and among all bytes
+        // in the capture.
+        std::uint64_t offset         = 0;
+        std::uint64_t capture_offset = 0;
+        std::int64_t  monotonic      = 0;
+        std::int64_t  realtime       = 0;
+        // Valid until the next call into the reader.
+        std::span<const char> bytes;
+    };
+
+    // Returns nullptr if `path` cannot be read or is not a capture.
+    [[nodiscard]] static auto open(const std::filesystem::path &path)
+      -> std::unique_ptr<CaptureReader>;
+
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader &)            = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+    CaptureReader(CaptureReader &&)                 = delete;
+    CaptureReader &operator=(CaptureReader &&)      = delete;
+
+    [[nodiscard]] const capture::FileHeader &header() const noexcept
+    {
+        return file_header;
+    }
+
+    // Every port the capture has a name for, in id order.
+    [[nodiscard]] std::vector<std::uint16_t> ports() const;
+
+    // Empty for ports the capture has no name for.
+    [[nodiscard]] std::string_view port_name(std::uint16_t port) const;
+
+    [[nodiscard]] std::uint64_t captured_bytes() const noexcept
+    {
+        return total;
+    }
+
+    // Whether the file ends in a torn batch that had to be ignored.
+    [[nodiscard]] bool recovered() const noexcept { return end < size; }
+
+    // The chunk after the previous one (or after a seek), nullopt at the
+    // end of the capture.
+    [[nodiscard]] std::optional<Chunk> next();
+
+    void rewind();
+
+    // Position at the first chunk read at or after `monotonic`, false if
+    // there is none.
+    bool seek_time(std::int64_t monotonic);
+
+    // Position at the chunk holding the `capture_offset`th captured byte,
+    // false if the capture is shorter.
+    bool seek_offset(std::uint64_t capture_offset);
+
+  private:
+    // What the reader keeps per batch, the entries themselves stay on disk.
+    struct Batch
+    {
+        std::uint64_t       index_offset = 0;
+        std::uint32_t       entries      = 0;
+        capture::IndexEntry first;
+    };
+
+    struct Record
+    {
+        capture::RecordHeader header;
+        std::span<const char> payload;
+    };
+
+    struct Index
+    {
+        capture::RecordHeader            header;
+        std::vector<capture::IndexEntry> entries;
+        std::span<const char>            names;
+    };
+
+    CaptureReader(int fd, std::uint64_t size);
+
+    // Chunks are read through a window of this size so sequential reading
+    // does not issue a syscall per chunk.
+    constexpr static std::size_t WINDOW_SIZE = 1024 * 1024;
+
+    int                 fd   = -1;
+    std::uint64_t       size = 0;
+    capture::FileHeader file_header;
+    std::vector<Batch>  batches;
+
+    std::unordered_map<std::uint16_t, std::string> names;
+
+    // Where the last intact batch ends and how many payload bytes precede
+    // it.
+    std::uint64_t end   = 0;
+    std::uint64_t total = 0;
+
+    std::uint64_t position        = 0;
+    std::uint64_t next_capture_at = 0;
+
+    std::uint64_t     window_offset = 0;
+    std::vector<char> window;
+
+    // `ahead` bytes are read in one go if the window has to be refilled.
+    [[nodiscard]] std::optional<std::span<const char>> fetch(
+      std::uint64_t offset,
+      std::size_t   length,
+      std::size_t   ahead = 0
+    );
+    [[nodiscard]] std::optional<Record>
+      record_at(std::uint64_t offset, std::size_t ahead = 0);
+    [[nodiscard]] std::optional<Index> index_at(std::uint64_t offset);
+
+    [[nodiscard]] bool load_from_footer();
+    void               load_by_scanning();
+    void               load_names(std::span<const char> table);
+    void               add_batch(std::uint64_t offset, const Index &index);
+    void               seek(std::size_t batch, std::size_t entry);
+};
+
+#endif // SESAMO_CAPTURE_READER_HPP
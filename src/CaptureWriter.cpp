@@ -0,0 +1,306 @@
+#include "CaptureWriter.hpp"
+#include "Trace.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <print>
+
+namespace
+{
+
+[[nodiscard]] bool write_all(const int fd, std::span<const char> bytes)
+{
+    while (!bytes.empty()) {
+        const auto written = ::write(fd, bytes.data(), bytes.size());
+        if (written < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+        bytes = bytes.subspan(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+template <typename Record>
+void append_bytes(std::vector<char> &out, const Record &record)
+{
+    // NOLINTNEXTLINE
+    const auto *bytes = reinterpret_cast<const char *>(&record);
+    out.insert(out.end(), bytes, bytes + sizeof(Record));
+}
+
+[[nodiscard]] std::int64_t since_epoch(const auto now)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             now.time_since_epoch()
+    )
+      .count();
+}
+
+} // namespace
+
+auto CaptureWriter::create(const std::filesystem::path &path)
+  -> std::shared_ptr<CaptureWriter>
+{
+    // NOLINTNEXTLINE
+    const auto fd =
+      ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to create capture {}: {}\n",
+          path.string(),
+          strerror(errno)
+        );
+        return nullptr;
+    }
+
+    capture::FileHeader header;
+    header.realtime  = since_epoch(std::chrono::system_clock::now());
+    header.monotonic = since_epoch(std::chrono::steady_clock::now());
+
+    // NOLINTNEXTLINE
+    const auto *bytes = reinterpret_cast<const char *>(&header);
+    if (!write_all(fd, { bytes, sizeof(header) }) || fdatasync(fd) != 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to write capture {}: {}\n",
+          path.string(),
+          strerror(errno)
+        );
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto writer = std::shared_ptr<CaptureWriter>(
+      new CaptureWriter(fd, sizeof(header))
+    );
+    writer->thread = std::thread(&CaptureWriter::run, writer.get());
+    return writer;
+}
+
+CaptureWriter::CaptureWriter(int fd, std::uint64_t file_offset)
+  : fd(fd),
+    queue(QUEUE_CAPACITY),
+    nudged(false),
+    file_offset(file_offset),
+    batches(0),
+    chunks(0),
+    bytes_written(0),
+    dropped(0),
+    dropped_records(0)
+{}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+    if (fd >= 0) { ::close(fd); }
+}
+
+std::uint16_t CaptureWriter::add_port(const std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto id = static_cast<std::uint16_t>(names.size());
+    names.emplace_back(id, name);
+    return id;
+}
+
+void CaptureWriter::append(
+  const capture::RecordHeader &chunk,
+  const std::span<const char>  bytes
+) noexcept
+{
+    auto header = chunk;
+    header.crc  = 0;
+    header.size = static_cast<std::uint32_t>(bytes.size());
+    header.type = capture::RecordType::Chunk;
+
+    // NOLINTNEXTLINE
+    const auto *raw = reinterpret_cast<const char *>(&header);
+    if (!queue.write({ raw, sizeof(header) }, bytes)) {
+        dropped.fetch_add(bytes.size(), std::memory_order_relaxed);
+        return;
+    }
+
+    // The writer sleeps for a whole interval otherwise, wake it once per
+    // batch when a burst threatens to fill the queue before that.
+    if (queue.size() > queue.capacity() / 2
+        && !nudged.exchange(true, std::memory_order_relaxed)) {
+        wakeup.notify_one();
+    }
+}
+
+void CaptureWriter::append_gap(const capture::RecordHeader &gap) noexcept
+{
+    auto header = gap;
+    header.crc  = 0;
+    header.size = 0;
+    header.type = capture::RecordType::Gap;
+
+    // Gaps are rare and tiny, the writer picks this one up on its next
+    // interval.
+    // NOLINTNEXTLINE
+    const auto *raw = reinterpret_cast<const char *>(&header);
+    if (!queue.write({ raw, sizeof(header) })) {
+        dropped_records.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void CaptureWriter::append_counters(
+  const capture::RecordHeader &sample,
+  const capture::Counters     &counters
+) noexcept
+{
+    auto header = sample;
+    header.crc  = 0;
+    header.size = sizeof(counters);
+    header.type = capture::RecordType::Counters;
+
+    // NOLINTNEXTLINE
+    const auto *raw = reinterpret_cast<const char *>(&header);
+    // NOLINTNEXTLINE
+    const auto *payload = reinterpret_cast<const char *>(&counters);
+    if (!queue.write({ raw, sizeof(header) }, { payload, sizeof(counters) })) {
+        dropped_records.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void CaptureWriter::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wakeup.notify_one();
+
+    if (thread.joinable()) { thread.join(); }
+}
+
+void CaptureWriter::run()
+{
+    SESAMO_TRACE_THREAD("capture");
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stop) {
+        wakeup.wait_for(lock, BATCH_INTERVAL, [this] {
+            return stop || nudged.load(std::memory_order_relaxed);
+        });
+
+        lock.unlock();
+        nudged.store(false, std::memory_order_relaxed);
+        write_batch();
+        lock.lock();
+    }
+    lock.unlock();
+
+    // Everything appended before close() was called.
+    write_batch();
+}
+
+void CaptureWriter::write_batch()
+{
+    SESAMO_TRACE_SCOPE("capture.batch");
+
+    batch.clear();
+    entries.clear();
+
+    // Only what is queued right now, a producer that keeps up with us must
+    // not keep the batch open forever.
+    auto          available = queue.size();
+    std::uint64_t recorded  = 0;
+    while (available >= sizeof(capture::RecordHeader)) {
+        capture::RecordHeader header;
+        // NOLINTNEXTLINE
+        auto *raw = reinterpret_cast<char *>(&header);
+        if (!queue.read({ raw, sizeof(header) })) { break; }
+
+        const auto position = batch.size();
+        batch.resize(position + sizeof(header) + header.size);
+        const auto payload =
+          std::span(batch).subspan(position + sizeof(header), header.size);
+        // Header and payload are queued together, the payload is there.
+        [[maybe_unused]] const auto _ = queue.read(payload);
+        available -= sizeof(header) + header.size;
+
+        entries.push_back({ .file_offset    = file_offset + position,
+                            .capture_offset = capture_offset,
+                            .monotonic      = header.monotonic });
+        if (header.type == capture::RecordType::Chunk) {
+            capture_offset += header.size;
+            ++recorded;
+        }
+
+        header.crc = capture::record_crc(header, payload);
+        std::memcpy(batch.data() + position, &header, sizeof(header));
+    }
+
+    // An idle capture costs nothing, and once the file could not be written
+    // there is no point in trying again.
+    if (entries.empty() || failed) { return; }
+
+    append_index();
+
+    if (!write_all(fd, batch) || fdatasync(fd) != 0) {
+        std::print(
+          stderr, "[ERROR] failed to write capture: {}\n", strerror(errno)
+        );
+        failed = true;
+        return;
+    }
+
+    file_offset += batch.size();
+    batches.fetch_add(1, std::memory_order_relaxed);
+    chunks.fetch_add(recorded, std::memory_order_relaxed);
+    bytes_written.fetch_add(batch.size(), std::memory_order_relaxed);
+}
+
+void CaptureWriter::append_index()
+{
+    // Every index carries all names, so the last one alone is enough.
+    std::vector<char> table;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &[port, name] : names) {
+            append_bytes(
+              table,
+              capture::PortName{
+                .port = port, .length = static_cast<std::uint16_t>(name.size())
+              }
+            );
+            table.insert(table.end(), name.begin(), name.end());
+        }
+    }
+
+    const auto position = batch.size();
+    batch.resize(position + sizeof(capture::RecordHeader));
+    append_bytes(
+      batch,
+      capture::IndexHeader{
+        .entries    = static_cast<std::uint32_t>(entries.size()),
+        .names_size = static_cast<std::uint32_t>(table.size()),
+      }
+    );
+    for (const auto &entry : entries) { append_bytes(batch, entry); }
+    batch.insert(batch.end(), table.begin(), table.end());
+
+    capture::RecordHeader header;
+    header.size = static_cast<std::uint32_t>(
+      batch.size() - position - sizeof(capture::RecordHeader)
+    );
+    header.type      = capture::RecordType::Index;
+    header.offset    = previous_index;
+    header.monotonic = entries.front().monotonic;
+    header.crc       = capture::record_crc(
+      header,
+      std::span(batch).subspan(position + sizeof(capture::RecordHeader))
+    );
+    std::memcpy(batch.data() + position, &header, sizeof(header));
+
+    previous_index = file_offset + position;
+
+    capture::Footer footer;
+    footer.index_offset = previous_index;
+    append_bytes(batch, footer);
+}
@@ -0,0 +1,132 @@
+#ifndef SESAMO_CAPTURE_WRITER_HPP
+#define SESAMO_CAPTURE_WRITER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CaptureFormat.hpp"
+#include "RingBuffer.hpp"
+
+// Appends chunks to a capture file (see CaptureFormat.hpp) from a thread of
+// its own.
+//
+// The reactor thread hands every read over through append(), which only
+// copies it into a queue. Every BATCH_INTERVAL the writer thread turns
+// what queued up into one batch, writes it with a single write(2) and
+// syncs it, so even a 3 Mbaud stream costs a handful of syscalls per second
+// and the reactor never waits on the disk.
+class [[nodiscard]] CaptureWriter final
+{
+  public:
+    struct Stats
+    {
+        std::uint64_t batches = 0;
+        std::uint64_t chunks  = 0;
+        std::uint64_t bytes   = 0;
+        // Chunk payload that did not fit into the queue.
+        std::uint64_t dropped = 0;
+        // Gap and Counters records that did not fit.
+        std::uint64_t dropped_records = 0;
+    };
+
+    constexpr static std::chrono::milliseconds BATCH_INTERVAL{ 200 };
+
+    // Enough for a few seconds of several fast ports, the writer is nudged
+    // to start a batch early once it is half full.
+    constexpr static std::size_t QUEUE_CAPACITY = 8 * 1024 * 1024;
+
+    // Creates (or truncates) `path` and starts the writer thread. Returns
+    // nullptr if the file cannot be written.
+    [[nodiscard]] static auto create(const std::filesystem::path &path)
+      -> std::shared_ptr<CaptureWriter>;
+
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter &)            = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+    CaptureWriter(CaptureWriter &&)                 = delete;
+    CaptureWriter &operator=(CaptureWriter &&)      = delete;
+
+    // Registers a port under `name` and returns the id its chunks are
+    // recorded with. Any thread.
+    [[nodiscard]] std::uint16_t add_port(std::string_view name);
+
+    // Queues one chunk, only `port`, `direction`, `offset` and the times of
+    // `chunk` are used. Single producer: only ever call this from one
+    // thread at a time, the reactor thread in practice.
+    void append(
+      const capture::RecordHeader &chunk,
+      std::span<const char>        bytes
+    ) noexcept;
+
+    // Queues a Gap record, only `port`, `offset` and the times of `gap` are
+    // used. Same producer as append().
+    void append_gap(const capture::RecordHeader &gap) noexcept;
+
+    // Queues a Counters record, only `port`, `offset` and the times of
+    // `sample` are used. Same producer as append().
+    void append_counters(
+      const capture::RecordHeader &sample,
+      const capture::Counters     &counters
+    ) noexcept;
+
+    // Writes out whatever is still queued and stops the writer thread.
+    // Nothing may be appended afterwards.
+    void close();
+
+    [[nodiscard]] Stats stats() const noexcept
+    {
+        return { .batches = batches.load(std::memory_order_relaxed),
+                 .chunks  = chunks.load(std::memory_order_relaxed),
+                 .bytes   = bytes_written.load(std::memory_order_relaxed),
+                 .dropped = dropped.load(std::memory_order_relaxed),
+                 .dropped_records =
+                   dropped_records.load(std::memory_order_relaxed) };
+    }
+
+  private:
+    CaptureWriter(int fd, std::uint64_t file_offset);
+
+    int        fd = -1;
+    RingBuffer queue;
+
+    std::mutex              mutex;
+    std::condition_variable wakeup;
+    bool                    stop = false; // guarded by mutex
+    std::atomic<bool>       nudged;
+    std::thread             thread;
+
+    // Names of the registered ports, guarded by mutex.
+    std::vector<std::pair<std::uint16_t, std::string>> names;
+
+    // Only ever touched by the writer thread.
+    std::uint64_t                    file_offset    = 0;
+    std::uint64_t                    capture_offset = 0;
+    std::uint64_t                    previous_index = 0;
+    bool                             failed         = false;
+    std::vector<char>                batch;
+    std::vector<capture::IndexEntry> entries;
+
+    std::atomic<std::uint64_t> batches;
+    std::atomic<std::uint64_t> chunks;
+    std::atomic<std::uint64_t> bytes_written;
+    std::atomic<std::uint64_t> dropped;
+    std::atomic<std::uint64_t> dropped_records;
+
+    void run();
+    void write_batch();
+    void append_index();
+};
+
+#endif // SESAMO_CAPTURE_WRITER_HPP
@@ -0,0 +1,405 @@
+#include "DeviceRegistry.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <span>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <print>
+
+namespace
+{
+
+constexpr std::string_view SYS_CLASS_TTY = "/sys/class/tty";
+constexpr std::string_view SYS_DEVICES   = "/sys/devices";
+constexpr std::string_view DEV_PATH      = "/dev";
+constexpr std::string_view BY_ID_PATH    = "/dev/serial/by-id";
+
+// Multicast groups of NETLINK_KOBJECT_UEVENT: events straight from the
+// kernel, and the same events re-sent by udev once it created the device
+// node's links and set its permissions.
+constexpr std::uint32_t KERNEL_EVENTS = 1;
+constexpr std::uint32_t UDEV_EVENTS   = 2;
+
+// udev's messages start with this header, kernel ones with
+// "<action>@<devpath>".
+constexpr std::string_view UDEV_PREFIX = { "libudev\0", 8 };
+
+struct UdevHeader
+{
+    std::array<char, 8> prefix;
+    std::uint32_t       magic;
+    std::uint32_t       header_size;
+    std::uint32_t       properties_offset;
+    std::uint32_t       properties_length;
+};
+
+// The first line of a sysfs attribute, empty if there is none.
+[[nodiscard]] std::string read_attribute(const std::filesystem::path &path)
+{
+    // NOLINTNEXTLINE
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { return {}; }
+
+    std::array<char, 256> buffer{};
+    const auto            length = ::read(fd, buffer.data(), buffer.size());
+    ::close(fd);
+    if (length <= 0) { return {}; }
+
+    const auto text =
+      std::string_view(buffer.data(), static_cast<std::size_t>(length));
+    return std::string(text.substr(0, text.find('\n')));
+}
+
+// Where the symlink `path` points, by its last component: the name of a
+// driver or subsystem.
+[[nodiscard]] std::string link_name(const std::filesystem::path &path)
+{
+    std::error_code error;
+    const auto      target = std::filesystem::read_symlink(path, error);
+    return error ? std::string{} : target.filename().string();
+}
+
+[[nodiscard]] std::uint16_t read_hex(const std::filesystem::path &path)
+{
+    const auto    text  = read_attribute(path);
+    std::uint16_t value = 0;
+    std::from_chars(text.data(), text.data() + text.size(), value, 16);
+    return value;
+}
+
+// A name the events hand us is only trusted to be a tty name.
+[[nodiscard]] bool is_tty_name(const std::string_view name)
+{
+    return !name.empty() && name != "." && name != ".."
+           && name.find('/') == std::string_view::npos;
+}
+
+} // namespace
+
+auto DeviceRegistry::spawn(std::function<void()> on_change)
+  -> std::unique_ptr<DeviceRegistry>
+{
+    const auto stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stop_fd < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to create device registry eventfd: {}\n",
+          strerror(errno)
+        );
+        return nullptr;
+    }
+
+    // Subscribe before the scan, so nothing happening in between is lost.
+    auto source    = Source::Netlink;
+    auto listen_fd = socket(
+      AF_NETLINK,
+      SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+      NETLINK_KOBJECT_UEVENT
+    );
+    if (listen_fd >= 0) {
+        sockaddr_nl address{};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = KERNEL_EVENTS | UDEV_EVENTS;
+        // NOLINTNEXTLINE
+        const auto *raw = reinterpret_cast<const sockaddr *>(&address);
+        if (bind(listen_fd, raw, sizeof(address)) < 0) {
+            ::close(listen_fd);
+            listen_fd = -1;
+        }
+    }
+
+    if (listen_fd < 0) {
+        source    = Source::Inotify;
+        listen_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+        if (listen_fd >= 0
+            && inotify_add_watch(
+                 listen_fd,
+                 DEV_PATH.data(),
+                 IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM
+               ) < 0) {
+            ::close(listen_fd);
+            listen_fd = -1;
+        }
+    }
+
+    if (listen_fd < 0) {
+        std::print(
+          stderr,
+          "[WARNING] cannot follow device hotplug, the port list will not "
+          "update: {}\n",
+          strerror(errno)
+        );
+        source = Source::None;
+    }
+
+    auto registry = std::unique_ptr<DeviceRegistry>(
+      new DeviceRegistry(stop_fd, listen_fd, source, std::move(on_change))
+    );
+    [[maybe_unused]] const auto _ = registry->scan();
+    if (source != Source::None) {
+        registry->thread = std::thread(&DeviceRegistry::run, registry.get());
+    }
+    return registry;
+}
+
+DeviceRegistry::DeviceRegistry(
+  int                   stop_fd,
+  int                   listen_fd,
+  Source                source,
+  std::function<void()> on_change
+)
+  : stop_fd(stop_fd),
+    listen_fd(listen_fd),
+    source(source),
+    on_change(std::move(on_change)),
+    changes(0)
+{}
+
+DeviceRegistry::~DeviceRegistry()
+{
+    const std::uint64_t one = 1;
+    // NOLINTNEXTLINE
+    [[maybe_unused]] const auto _ = ::write(stop_fd, &one, sizeof(one));
+    if (thread.joinable()) { thread.join(); }
+
+    if (listen_fd >= 0) { ::close(listen_fd); }
+    ::close(stop_fd);
+}
+
+std::vector<DeviceRegistry::Device> DeviceRegistry::devices() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries;
+}
+
+auto DeviceRegistry::describe(const std::string_view name)
+  -> std::optional<Device>
+{
+    if (!is_tty_name(name)) { return std::nullopt; }
+    const auto tty = std::filesystem::path(SYS_CLASS_TTY) / name;
+
+    // Virtual consoles, ptys and the like have no device behind them.
+    std::error_code error;
+    auto            device = std::filesystem::canonical(tty / "device", error);
+    if (error) { return std::nullopt; }
+
+    // Since Linux 6.5 the serial core puts a controller and a port device
+    // of its own between the tty and the hardware.
+    while (link_name(device / "subsystem") == "serial-base") {
+        device = device.parent_path();
+    }
+
+    // The 8250 driver registers its ports whether or not there is a UART
+    // behind them, those that found none report type 0 (PORT_UNKNOWN).
+    if (read_attribute(tty / "type") == "0") { return std::nullopt; }
+
+    Device result;
+    result.path      = (std::filesystem::path(DEV_PATH) / name).string();
+    result.driver    = link_name(device / "driver");
+    result.subsystem = link_name(device / "subsystem");
+
+    // usb-serial hangs the port below its interface and cdc-acm the tty
+    // right off it, either way the USB device is the first ancestor with
+    // an idVendor.
+    for (auto ancestor = device;
+         ancestor.string().starts_with(SYS_DEVICES)
+         && ancestor != ancestor.parent_path();
+         ancestor = ancestor.parent_path()) {
+        if (!std::filesystem::exists(ancestor / "idVendor", error)) {
+            continue;
+        }
+
+        result.vendor_id    = read_hex(ancestor / "idVendor");
+        result.product_id   = read_hex(ancestor / "idProduct");
+        result.manufacturer = read_attribute(ancestor / "manufacturer");
+        result.product      = read_attribute(ancestor / "product");
+        result.serial       = read_attribute(ancestor / "serial");
+        break;
+    }
+
+    auto links = std::filesystem::directory_iterator(BY_ID_PATH, error);
+    for (; !error && links != std::filesystem::directory_iterator();
+         links.increment(error)) {
+        std::error_code ignored;
+        if (std::filesystem::canonical(links->path(), ignored)
+            == result.path) {
+            result.by_id = links->path().string();
+            break;
+        }
+    }
+
+    return result;
+}
+
+void DeviceRegistry::run()
+{
+    SESAMO_TRACE_THREAD("devices");
+
+    std::array<pollfd, 2> fds{};
+    fds[0].fd     = stop_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd     = listen_fd;
+    fds[1].events = POLLIN;
+
+    while (true) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) { continue; }
+            std::print(
+              stderr,
+              "[ERROR] failed to wait for device events: {}\n",
+              strerror(errno)
+            );
+            return;
+        }
+        if ((fds[0].revents & POLLIN) != 0) { return; }
+
+        const auto changed = source == Source::Netlink ? handle_netlink()
+                                                       : handle_inotify();
+        if (changed && on_change) { on_change(); }
+    }
+}
+
+bool DeviceRegistry::scan()
+{
+    std::vector<Device> found;
+    std::error_code     error;
+    auto ttys = std::filesystem::directory_iterator(SYS_CLASS_TTY, error);
+    for (; !error && ttys != std::filesystem::directory_iterator();
+         ttys.increment(error)) {
+        if (auto device = describe(ttys->path().filename().string())) {
+            found.push_back(std::move(*device));
+        }
+    }
+    std::ranges::sort(found, {}, &Device::path);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (found == entries) { return false; }
+    entries = std::move(found);
+    changes.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+bool DeviceRegistry::refresh(const std::string_view name)
+{
+    // Outside the lock, sysfs reads can take a while on a busy bus.
+    auto       device = describe(name);
+    const auto path   = (std::filesystem::path(DEV_PATH) / name).string();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto at = std::ranges::lower_bound(entries, path, {}, &Device::path);
+    const auto present = at != entries.end() && at->path == path;
+    if (!device) {
+        if (!present) { return false; }
+        entries.erase(at);
+    } else if (present) {
+        if (*at == *device) { return false; }
+        *at = std::move(*device);
+    } else {
+        entries.insert(at, std::move(*device));
+    }
+
+    changes.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+bool DeviceRegistry::handle_netlink()
+{
+    SESAMO_TRACE_SCOPE("devices.uevent");
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+    std::array<char, EVENT_BUFFER_SIZE> buffer;
+    auto                                changed = false;
+    while (true) {
+        const auto length = recv(listen_fd, buffer.data(), buffer.size(), 0);
+        if (length < 0) {
+            if (errno == EINTR) { continue; }
+            // The socket overflowed and events were lost, start over.
+            if (errno == ENOBUFS) {
+                changed = scan() || changed;
+                continue;
+            }
+            return changed;
+        }
+
+        auto message =
+          std::string_view(buffer.data(), static_cast<std::size_t>(length));
+        if (message.starts_with(UDEV_PREFIX)) {
+            if (message.size() < sizeof(UdevHeader)) { continue; }
+            UdevHeader header{};
+            std::memcpy(&header, message.data(), sizeof(header));
+            if (header.properties_offset > message.size()) { continue; }
+            message = message.substr(header.properties_offset);
+        } else {
+            const auto summary = message.find('\0');
+            if (summary == std::string_view::npos) { continue; }
+            message = message.substr(summary + 1);
+        }
+
+        // Only what the event is about is taken from it, everything else
+        // comes from sysfs: anyone can send to these groups.
+        std::string_view subsystem;
+        std::string_view name;
+        while (!message.empty()) {
+            const auto end      = message.find('\0');
+            const auto property = message.substr(0, end);
+            if (property.starts_with("SUBSYSTEM=")) {
+                subsystem = property.substr(std::strlen("SUBSYSTEM="));
+            } else if (property.starts_with("DEVNAME=")) {
+                name = property.substr(std::strlen("DEVNAME="));
+                // udev sends the whole /dev path.
+                name = name.substr(name.rfind('/') + 1);
+            }
+            if (end == std::string_view::npos) { break; }
+            message = message.substr(end + 1);
+        }
+
+        if (subsystem == "tty" && is_tty_name(name)) {
+            changed = refresh(name) || changed;
+        }
+    }
+}
+
+bool DeviceRegistry::handle_inotify()
+{
+    SESAMO_TRACE_SCOPE("devices.inotify");
+
+    alignas(inotify_event) std::array<char, EVENT_BUFFER_SIZE> buffer{};
+    auto changed = false;
+    while (true) {
+        const auto length = ::read(listen_fd, buffer.data(), buffer.size());
+        if (length < 0) {
+            if (errno == EINTR) { continue; }
+            return changed;
+        }
+
+        auto events = std::span(buffer).first(static_cast<std::size_t>(length));
+        while (events.size() >= sizeof(inotify_event)) {
+            inotify_event event{};
+            std::memcpy(&event, events.data(), sizeof(event));
+            const auto name = std::string_view(
+              events.subspan(sizeof(event)).data(),
+              std::min<std::size_t>(event.len, events.size() - sizeof(event))
+            );
+            events = events.subspan(
+              std::min(sizeof(event) + event.len, events.size())
+            );
+
+            // The name is padded with NULs up to `len`.
+            const auto tty = name.substr(0, name.find('\0'));
+            if (tty.starts_with("tty")) {
+                changed = refresh(tty) || changed;
+            }
+        }
+    }
+}
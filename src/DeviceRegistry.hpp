@@ -0,0 +1,113 @@
+#ifndef SESAMO_DEVICE_REGISTRY_HPP
+#define SESAMO_DEVICE_REGISTRY_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// The serial ports present on the machine, kept current as devices come
+// and go.
+//
+// Ports are found in /sys/class/tty, which only lists ttys the kernel
+// registered, and only those with a device behind them are kept, so the
+// dozens of virtual consoles and ptys never show up. After one scan on
+// spawn a thread of its own follows kernel and udev uevents over netlink
+// (or, where netlink is not available, inotify on /dev) and only looks
+// at the one tty an event names. Readers take a snapshot whenever
+// `generation()` moved, they never wait on sysfs.
+class [[nodiscard]] DeviceRegistry final
+{
+  public:
+    struct Device
+    {
+        // What to open, /dev/<name>.
+        std::string path;
+        // Kernel driver and the bus it sits on, e.g. "ftdi_sio" and
+        // "usb-serial", "cdc_acm" and "usb", "serial" and "pnp".
+        std::string driver;
+        std::string subsystem;
+        // Of the USB device the port belongs to, zero and empty otherwise
+        // or when the device does not say.
+        std::uint16_t vendor_id  = 0;
+        std::uint16_t product_id = 0;
+        std::string   manufacturer;
+        std::string   product;
+        std::string   serial;
+        // The /dev/serial/by-id link udev made for it, empty if none.
+        std::string by_id;
+
+        bool operator==(const Device &) const = default;
+    };
+
+    // `on_change` is called on the registry's thread whenever a device was
+    // added, removed or changed. Returns nullptr if the thread could not be
+    // set up, a registry that cannot follow hotplug still lists what was
+    // there on spawn.
+    [[nodiscard]] static auto spawn(std::function<void()> on_change = {})
+      -> std::unique_ptr<DeviceRegistry>;
+
+    ~DeviceRegistry();
+
+    DeviceRegistry(const DeviceRegistry &)            = delete;
+    DeviceRegistry &operator=(const DeviceRegistry &) = delete;
+    DeviceRegistry(DeviceRegistry &&)                 = delete;
+    DeviceRegistry &operator=(DeviceRegistry &&)      = delete;
+
+    // Bumped on every change, cheap enough to poll once a frame.
+    [[nodiscard]] std::uint64_t generation() const noexcept
+    {
+        return changes.load(std::memory_order_acquire);
+    }
+
+    // Every device present, ordered by path.
+    [[nodiscard]] std::vector<Device> devices() const;
+
+    // Reads what sysfs knows about tty `name`, nullopt if it is not a port
+    // with a device behind it.
+    [[nodiscard]] static std::optional<Device> describe(std::string_view name);
+
+  private:
+    enum class Source : std::uint8_t
+    {
+        None,
+        Netlink,
+        Inotify,
+    };
+
+    DeviceRegistry(
+      int                   stop_fd,
+      int                   listen_fd,
+      Source                source,
+      std::function<void()> on_change
+    );
+
+    // Room for one uevent, the kernel caps them at 2 KiB and udev's carry
+    // every property on top.
+    constexpr static std::size_t EVENT_BUFFER_SIZE = 8 * 1024;
+
+    int                   stop_fd   = -1;
+    int                   listen_fd = -1;
+    Source                source    = Source::None;
+    std::function<void()> on_change;
+    std::thread           thread;
+
+    mutable std::mutex         mutex;
+    std::vector<Device>        entries; // guarded by mutex
+    std::atomic<std::uint64_t> changes;
+
+    void run();
+    // Each returns whether the list changed.
+    [[nodiscard]] bool scan();
+    [[nodiscard]] bool refresh(std::string_view name);
+    [[nodiscard]] bool handle_netlink();
+    [[nodiscard]] bool handle_inotify();
+};
+
+#endif // SESAMO_DEVICE_REGISTRY_HPP
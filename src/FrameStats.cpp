@@ -0,0 +1,136 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+
+[[nodiscard]] float to_milliseconds(const FrameStats::Clock::duration duration)
+{
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+} // namespace
+
+float FrameStats::Series::average() const noexcept
+{
+    return std::accumulate(values.begin(), values.end(), 0.0F)
+           / static_cast<float>(HISTORY);
+}
+
+float FrameStats::Series::max() const noexcept
+{
+    return std::ranges::max(values);
+}
+
+std::string_view FrameStats::name(const Stage stage)
+{
+    switch (stage) {
+        case Stage::Input: return "input";
+        case Stage::Drain: return "drain";
+        case Stage::Append: return "append";
+        case Stage::Layout: return "layout";
+        case Stage::Render: return "render";
+        case Stage::Draw: return "draw";
+    }
+    return "unknown";
+}
+
+void FrameStats::set_enabled(const bool enabled)
+{
+    if (enabled && !active) {
+        pending.fill(Clock::duration::zero());
+        pending_bytes  = 0;
+        arrival_count  = 0;
+        arrival_seen   = 0;
+        arrival_stride = 1;
+        last_end.reset();
+        reset_latencies();
+    }
+    active = enabled;
+}
+
+void FrameStats::add_arrival(const std::int64_t monotonic) noexcept
+{
+    if (arrival_seen++ % arrival_stride != 0) { return; }
+
+    if (arrival_count == ARRIVALS) {
+        for (std::size_t i = 0; i < ARRIVALS / 2; ++i) {
+            arrivals[i] = arrivals[i * 2];
+        }
+        arrival_count   = ARRIVALS / 2;
+        arrival_stride *= 2;
+        // The one at hand may not be on the new stride.
+        if ((arrival_seen - 1) % arrival_stride != 0) { return; }
+    }
+    arrivals[arrival_count++] = monotonic;
+}
+
+void FrameStats::reset_latencies() noexcept
+{
+    distribution.clear();
+    distribution_plot.fill(0.0F);
+}
+
+void FrameStats::end_frame(
+  const std::size_t memory, const std::uint64_t wakeups
+)
+{
+    // Appends happen inside the drain, only count them once.
+    const auto append = pending[static_cast<std::size_t>(Stage::Append)];
+    auto      &drain  = pending[static_cast<std::size_t>(Stage::Drain)];
+    drain            -= std::min(drain, append);
+
+    auto sum = Clock::duration::zero();
+    for (std::size_t i = 0; i < STAGE_COUNT; ++i) {
+        stages[i].push(to_milliseconds(pending[i]));
+        sum += pending[i];
+    }
+    frames.push(to_milliseconds(sum));
+    ingested.push(static_cast<float>(pending_bytes));
+    footprint.push(static_cast<float>(memory) / (1024.0F * 1024.0F));
+
+    const auto now = Clock::now();
+    if (last_end) {
+        const auto seconds =
+          std::chrono::duration<float>(now - *last_end).count();
+        wakeup_rate.push(
+          seconds > 0 ? static_cast<float>(wakeups - last_wakeups) / seconds
+                      : 0.0F
+        );
+    } else {
+        wakeup_rate.push(0.0F);
+    }
+    last_end     = now;
+    last_wakeups = wakeups;
+
+    // The frame was just presented, so this is as late as its reads get.
+    const auto presented =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now.time_since_epoch()
+      );
+    for (std::size_t i = 0; i < arrival_count; ++i) {
+        distribution.record(
+          presented - std::chrono::nanoseconds(arrivals[i]), arrival_stride
+        );
+    }
+    oldest.push(
+      arrival_count == 0
+        ? 0.0F
+        : to_milliseconds(presented - std::chrono::nanoseconds(arrivals[0]))
+    );
+    if (arrival_count > 0) {
+        std::ranges::transform(
+          distribution.buckets(),
+          distribution_plot.begin(),
+          [](const std::uint64_t count) { return static_cast<float>(count); }
+        );
+    }
+    arrival_count  = 0;
+    arrival_seen   = 0;
+    arrival_stride = 1;
+
+    pending.fill(Clock::duration::zero());
+    pending_bytes = 0;
+}
@@ -0,0 +1,202 @@
+#ifndef SESAMO_FRAME_STATS_HPP
+#define SESAMO_FRAME_STATS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "LatencyHistogram.hpp"
+
+// What the UI loop spends its frames on, for the performance overlay.
+//
+// Every figure is kept in a fixed-size ring of the last HISTORY frames that
+// ImGui::PlotHistogram draws as is, nothing allocates after construction.
+// While disabled a Scope does not even read the clock and no frame is
+// recorded, so the hidden overlay costs a branch per stage.
+//
+// Byte to pixel latency runs from the moment a read returned to the end of
+// the glfwSwapBuffers() of the frame that first showed its bytes.
+class [[nodiscard]] FrameStats final
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Stage : std::uint8_t
+    {
+        // handle_input().
+        Input,
+        // Serial::read_all() and read_arrivals() of every port, without the
+        // scrollback appends.
+        Drain,
+        // Scrollback::append() of what was drained.
+        Append,
+        // Building the ImGui frame, NewFrame() up to Render().
+        Layout,
+        // ImGui::Render().
+        Render,
+        // ImGui_ImplOpenGL3_RenderDrawData().
+        Draw,
+    };
+
+    constexpr static std::size_t STAGE_COUNT = 6;
+    constexpr static std::size_t HISTORY     = 240;
+    // Reads per frame whose latency is recorded, past that they are sampled.
+    constexpr static std::size_t ARRIVALS    = 1024;
+
+    // The last HISTORY values of one figure, the oldest one at `offset()`.
+    class Series
+    {
+      public:
+        void push(const float value) noexcept
+        {
+            values[next] = value;
+            next         = (next + 1) % HISTORY;
+        }
+
+        [[nodiscard]] const float *data() const noexcept
+        {
+            return values.data();
+        }
+
+        [[nodiscard]] int offset() const noexcept
+        {
+            return static_cast<int>(next);
+        }
+
+        [[nodiscard]] float last() const noexcept
+        {
+            return values[(next + HISTORY - 1) % HISTORY];
+        }
+
+        [[nodiscard]] float average() const noexcept;
+        [[nodiscard]] float max() const noexcept;
+
+      private:
+        std::array<float, HISTORY> values{};
+        std::size_t                next = 0;
+    };
+
+    // Adds the time until it goes out of scope to `stage` of the current
+    // frame. Stages can be entered several times per frame.
+    class [[nodiscard]] Scope final
+    {
+      public:
+        Scope(FrameStats &stats, const Stage stage) noexcept
+          : stats(stats.enabled() ? &stats : nullptr),
+            stage(stage)
+        {
+            if (this->stats != nullptr) { start = Clock::now(); }
+        }
+
+        ~Scope()
+        {
+            if (stats != nullptr) { stats->add(stage, Clock::now() - start); }
+        }
+
+        Scope(const Scope &)            = delete;
+        Scope &operator=(const Scope &) = delete;
+        Scope(Scope &&)                 = delete;
+        Scope &operator=(Scope &&)      = delete;
+
+      private:
+        FrameStats       *stats = nullptr;
+        Stage             stage;
+        Clock::time_point start;
+    };
+
+    [[nodiscard]] static std::string_view name(const Stage stage);
+
+    [[nodiscard]] bool enabled() const noexcept { return active; }
+
+    // Enabling starts over from a clean frame, whatever was counted while
+    // disabled is dropped.
+    void set_enabled(const bool enabled);
+
+    void add(const Stage stage, const Clock::duration duration) noexcept
+    {
+        pending[static_cast<std::size_t>(stage)] += duration;
+    }
+
+    void add_bytes(const std::uint64_t bytes) noexcept
+    {
+        pending_bytes += bytes;
+    }
+
+    // A read whose bytes this frame shows, `monotonic` is its receive time
+    // as stamped by Serial.
+    void add_arrival(const std::int64_t monotonic) noexcept;
+
+    // Starts the byte to pixel distribution over.
+    void reset_latencies() noexcept;
+
+    // Records the frame counted so far. `memory` is the scrollback footprint
+    // and `wakeups` the reader thread's running wakeup count.
+    void end_frame(const std::size_t memory, const std::uint64_t wakeups);
+
+    // Milliseconds per frame.
+    [[nodiscard]] const Series &stage(const Stage stage) const noexcept
+    {
+        return stages[static_cast<std::size_t>(stage)];
+    }
+
+    // Milliseconds per frame, all stages together.
+    [[nodiscard]] const Series &total() const noexcept { return frames; }
+
+    [[nodiscard]] const Series &bytes() const noexcept { return ingested; }
+
+    // MiB.
+    [[nodiscard]] const Series &memory() const noexcept { return footprint; }
+
+    [[nodiscard]] const Series &wakeups_per_second() const noexcept
+    {
+        return wakeup_rate;
+    }
+
+    // Milliseconds per frame, the byte to pixel latency of its oldest read.
+    [[nodiscard]] const Series &latency() const noexcept { return oldest; }
+
+    // Byte to pixel latency of every read since enabling or the last reset.
+    [[nodiscard]] const LatencyHistogram &latencies() const noexcept
+    {
+        return distribution;
+    }
+
+    // `latencies()` as floats for plotting.
+    [[nodiscard]] const std::array<float, LatencyHistogram::BUCKETS> &
+      latency_buckets() const noexcept
+    {
+        return distribution_plot;
+    }
+
+  private:
+    bool active = false;
+
+    std::array<Clock::duration, STAGE_COUNT> pending{};
+    std::uint64_t                            pending_bytes = 0;
+
+    // Where the wakeup rate of the next frame is measured from.
+    std::optional<Clock::time_point> last_end;
+    std::uint64_t                    last_wakeups = 0;
+
+    // Every `stride`th read of the frame, the stride doubles whenever the
+    // array fills up and half of it is thrown out.
+    std::array<std::int64_t, ARRIVALS> arrivals{};
+    std::size_t                        arrival_count  = 0;
+    std::uint64_t                      arrival_seen   = 0;
+    std::uint64_t                      arrival_stride = 1;
+
+    LatencyHistogram                             distribution;
+    std::array<float, LatencyHistogram::BUCKETS> distribution_plot{};
+
+    std::array<Series, STAGE_COUNT> stages;
+    Series                          frames;
+    Series                          ingested;
+    Series                          footprint;
+    Series                          wakeup_rate;
+    Series                          oldest;
+};
+
+#endif // SESAMO_FRAME_STATS_HPP
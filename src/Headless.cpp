@@ -0,0 +1,475 @@
+#include "Headless.hpp"
+#include "Trace.hpp"
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <format>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include <print>
+
+namespace
+{
+
+[[nodiscard]] bool write_all(const int fd, std::string_view bytes)
+{
+    while (!bytes.empty()) {
+        const auto written = ::write(fd, bytes.data(), bytes.size());
+        if (written < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+        bytes.remove_prefix(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+} // namespace
+
+auto Headless::spawn(const Options &options) -> std::unique_ptr<Headless>
+{
+    if (options.paths.empty()) {
+        std::print(stderr, "[ERROR] no serial port to capture\n");
+        return nullptr;
+    }
+
+    // Block the signals before the reactor thread exists so it inherits the
+    // mask and they are only ever delivered through the signalfd.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    if (!options.trace.empty()) { sigaddset(&signals, SIGUSR1); }
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    const auto signal_fd = signalfd(-1, &signals, SFD_CLOEXEC);
+    if (signal_fd < 0) {
+        std::print(
+          stderr, "[ERROR] failed to create signalfd: {}\n", strerror(errno)
+        );
+        return nullptr;
+    }
+
+    const auto wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeup_fd < 0) {
+        std::print(
+          stderr, "[ERROR] failed to create eventfd: {}\n", strerror(errno)
+        );
+        ::close(signal_fd);
+        return nullptr;
+    }
+
+    auto headless = std::unique_ptr<Headless>(
+      new Headless(options, wakeup_fd, signal_fd)
+    );
+
+    const auto notify = [wakeup_fd] {
+        const std::uint64_t one = 1;
+        // NOLINTNEXTLINE
+        [[maybe_unused]] const auto _ = ::write(wakeup_fd, &one, sizeof(one));
+    };
+    headless->reactor = Reactor::spawn(options.reader_backend, notify);
+    if (!headless->reactor) {
+        std::print(stderr, "[ERROR] failed to start the serial reactor\n");
+        return nullptr;
+    }
+
+    if (!options.capture.empty()) {
+        headless->capture = CaptureWriter::create(options.capture);
+        if (!headless->capture) { return nullptr; }
+    }
+
+    if (!headless->open_ports()) { return nullptr; }
+
+    // After the ports are open, so their buffers are in what gets reported.
+    if (options.reader_tuning.requested()) {
+        const auto tuned = headless->reactor->tune(options.reader_tuning);
+        std::print(
+          stderr,
+          "reader thread: {}\n",
+          Reactor::describe(options.reader_tuning, tuned)
+        );
+    }
+
+    return headless;
+}
+
+Headless::Headless(const Options &options, int wakeup_fd, int signal_fd)
+  : options(options),
+    shared_output(
+      options.output_directory.empty() && options.paths.size() > 1
+    ),
+    wakeup_fd(wakeup_fd),
+    signal_fd(signal_fd)
+{}
+
+Headless::~Headless()
+{
+    for (auto &port : ports) {
+        if (port.serial) { port.serial->close(); }
+        if (port.output >= 0 && port.output != STDOUT_FILENO) {
+            ::close(port.output);
+        }
+    }
+    ports.clear();
+
+    // No port records into it anymore, write out the last batch.
+    if (capture) { capture->close(); }
+
+    // The reactor's activity callback writes into wakeup_fd.
+    reactor.reset();
+
+    ::close(wakeup_fd);
+    ::close(signal_fd);
+}
+
+bool Headless::open_ports()
+{
+    if (shared_output && options.format == Format::Raw) {
+        std::print(
+          stderr,
+          "[ERROR] raw capture of several ports needs an output directory\n"
+        );
+        return false;
+    }
+
+    for (const auto &path : options.paths) {
+        auto &port = ports.emplace_back();
+        port.path  = path;
+        if (shared_output) {
+            port.label = std::format(
+              "[{}] ", std::filesystem::path(path).filename().string()
+            );
+        }
+
+        if (options.output_directory.empty()) {
+            port.output = STDOUT_FILENO;
+        } else {
+            const auto file =
+              std::filesystem::path(options.output_directory)
+              / (std::filesystem::path(path).filename().string() + ".log");
+            port.output = ::open(
+              file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644
+            );
+            if (port.output < 0) {
+                std::print(
+                  stderr,
+                  "[ERROR] failed to open {}: {}\n",
+                  file.string(),
+                  strerror(errno)
+                );
+                return false;
+            }
+        }
+
+        const auto serial =
+          Serial::open(path, options.baud_rate, reactor, options.buffering);
+        if (!serial) { return false; }
+        port.serial = *serial;
+        port.serial->capture_realtime(options.timestamps);
+        port.serial->reconnect(options.reconnect);
+
+        if (capture
+            && !port.serial->record(capture, capture->add_port(path))) {
+            std::print(stderr, "[ERROR] failed to record {}\n", path);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int Headless::run()
+{
+    std::array<pollfd, 2> fds{};
+    fds[0].fd     = wakeup_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd     = signal_fd;
+    fds[1].events = POLLIN;
+
+    SESAMO_TRACE_THREAD("headless");
+
+    auto status = 0;
+    while (true) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) { continue; }
+            std::print(
+              stderr, "[ERROR] failed to wait for data: {}\n", strerror(errno)
+            );
+            status = 1;
+            break;
+        }
+
+        if ((fds[1].revents & POLLIN) != 0 && !handle_signal()) { break; }
+
+        std::uint64_t counter = 0;
+        // NOLINTNEXTLINE
+        [[maybe_unused]] const auto _ =
+          ::read(wakeup_fd, &counter, sizeof(counter));
+        reactor->acknowledge_activity();
+
+        auto connected = false;
+        auto failed    = false;
+        for (auto &port : ports) {
+            drain(port);
+            failed    = failed || !flush(port, false);
+            connected = connected || port.serial->is_connected()
+                        || port.serial->is_reconnecting();
+        }
+
+        if (failed) {
+            status = 1;
+            break;
+        }
+        if (!connected) { break; }
+    }
+
+    // Whatever arrived after the last wakeup, then any unterminated line.
+    for (auto &port : ports) {
+        drain(port);
+        if (!flush(port, true)) { status = 1; }
+
+        const auto stats = port.serial->stats();
+        std::print(
+          stderr,
+          "{}: {} bytes, {} dropped ({}){}\n",
+          port.path,
+          port.offset,
+          port.serial->dropped_bytes(),
+          Serial::describe(port.serial->backpressure()),
+          stats.pauses > 0 || stats.spilled > 0
+            ? std::format(
+                ", paused {} times, {} bytes spilled",
+                stats.pauses,
+                stats.spilled
+              )
+            : ""
+        );
+        if (port.counters) {
+            std::print(
+              stderr,
+              "{}: driver counted {} rx, {} tx, {}\n",
+              port.path,
+              port.counters->rx,
+              port.counters->tx,
+              port.counters->errors() > 0 ? port.counters->describe_errors()
+                                          : "no line errors"
+            );
+        }
+    }
+
+    if (capture) {
+        for (auto &port : ports) { port.serial->close(); }
+        capture->close();
+
+        const auto stats = capture->stats();
+        std::print(
+          stderr,
+          "{}: {} chunks in {} batches, {} bytes and {} other records "
+          "dropped\n",
+          options.capture,
+          stats.chunks,
+          stats.batches,
+          stats.dropped,
+          stats.dropped_records
+        );
+    }
+
+    if (!options.trace.empty() && !trace::dump(options.trace)) { status = 1; }
+
+    return status;
+}
+
+bool Headless::handle_signal()
+{
+    signalfd_siginfo info{};
+    if (::read(signal_fd, &info, sizeof(info)) != sizeof(info)) {
+        return true;
+    }
+    if (info.ssi_signo != SIGUSR1) { return false; }
+
+    if (trace::dump(options.trace)) {
+        std::print(stderr, "trace written to {}\n", options.trace);
+    }
+    return true;
+}
+
+void Headless::drain(Port &port)
+{
+    SESAMO_TRACE_SCOPE("headless.drain");
+
+    // Take the bytes before their timestamps, so a timestamp exists for
+    // every byte but possibly the ones read in the last few nanoseconds.
+    port.serial->read_gaps([&port](const Serial::Gap &gap) {
+        std::print(
+          stderr,
+          "{}: reconnected after {:.3f} s\n",
+          port.path,
+          static_cast<double>(gap.resumed - gap.lost) / 1e9
+        );
+    });
+
+    port.serial->read_counters([&port](const Serial::CounterSample &sample) {
+        const auto increase = sample.counters.since(
+          port.counters.value_or(Serial::LineCounters{})
+        );
+        if (increase.errors() > 0) {
+            std::print(
+              stderr,
+              "{}: line errors before byte {}: {}\n",
+              port.path,
+              sample.end,
+              increase.describe_errors()
+            );
+        }
+        port.counters = sample.counters;
+    });
+
+    port.staging.clear();
+    port.serial->read_all(
+      [&port](const std::span<const char> bytes) {
+          port.staging.insert(port.staging.end(), bytes.begin(), bytes.end());
+      },
+      [this, &port](const std::size_t discarded) {
+          std::print(
+            stderr,
+            "{}: dropped {} bytes at byte {}\n",
+            port.path,
+            discarded,
+            port.offset
+          );
+          // A hex row does not go on across the hole.
+          if (options.format == Format::Hex
+              && port.offset % HEX_ROW_SIZE != 0) {
+              port.pending.push_back('\n');
+              port.line_start = true;
+          }
+          port.offset += discarded;
+      }
+    );
+    port.serial->read_arrivals([&port](const Timeline::Arrival &arrival) {
+        port.timeline.append(arrival);
+    });
+
+    switch (options.format) {
+        case Format::Raw: {
+            port.pending.append(port.staging.begin(), port.staging.end());
+            port.offset += port.staging.size();
+            break;
+        }
+        case Format::Text: {
+            format_text(port, port.staging);
+            break;
+        }
+        case Format::Hex: {
+            format_hex(port, port.staging);
+            break;
+        }
+    }
+
+    port.timeline.discard_before(port.offset);
+}
+
+void Headless::format_text(Port &port, std::span<const char> bytes)
+{
+    if (port.label.empty() && !options.timestamps) {
+        port.pending.append(bytes.begin(), bytes.end());
+        port.offset += bytes.size();
+        return;
+    }
+
+    while (!bytes.empty()) {
+        if (port.line_start) {
+            prefix(port);
+            port.line_start = false;
+        }
+
+        const auto newline = std::ranges::find(bytes, '\n');
+        const auto count   = static_cast<std::size_t>(
+          newline == bytes.end() ? bytes.size() : newline - bytes.begin() + 1
+        );
+        port.pending.append(bytes.data(), count);
+        port.offset     += count;
+        port.line_start  = newline != bytes.end();
+        bytes            = bytes.subspan(count);
+    }
+}
+
+void Headless::format_hex(Port &port, const std::span<const char> bytes)
+{
+    constexpr std::string_view DIGITS = "0123456789abcdef";
+
+    for (const auto byte : bytes) {
+        if (port.offset % HEX_ROW_SIZE == 0 || port.line_start) {
+            port.line_start = false;
+            prefix(port);
+            std::format_to(
+              std::back_inserter(port.pending), "{:08x}:", port.offset
+            );
+        }
+
+        const auto value = static_cast<unsigned char>(byte);
+        port.pending.push_back(' ');
+        port.pending.push_back(DIGITS[value >> 4U]);
+        port.pending.push_back(DIGITS[value & 0xfU]);
+
+        ++port.offset;
+        if (port.offset % HEX_ROW_SIZE == 0) { port.pending.push_back('\n'); }
+    }
+}
+
+void Headless::prefix(Port &port)
+{
+    port.pending += port.label;
+    if (!options.timestamps) { return; }
+
+    // Only the bytes of a read that just landed can miss their timestamp,
+    // now is as good as it gets for those.
+    auto realtime = std::int64_t{ 0 };
+    if (const auto time = port.timeline.at(port.offset); time) {
+        realtime = time->realtime;
+    }
+    if (realtime == 0) {
+        realtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::system_clock::now().time_since_epoch()
+        )
+                     .count();
+    }
+
+    std::array<char, Timeline::TIME_TEXT_SIZE> text{};
+    port.pending += Timeline::format_wall_clock(text, realtime);
+    port.pending += ' ';
+}
+
+bool Headless::flush(Port &port, const bool everything)
+{
+    // Lines of several ports share stdout, keep partial ones back so they
+    // never get spliced into each other.
+    auto size = port.pending.size();
+    if (shared_output && !everything) {
+        const auto last = port.pending.rfind('\n');
+        size            = last == std::string::npos ? 0 : last + 1;
+    }
+    if (size == 0) { return true; }
+
+    const auto bytes = std::string_view(port.pending).substr(0, size);
+    if (!write_all(port.output, bytes)) {
+        std::print(
+          stderr,
+          "[ERROR] failed to write capture of {}: {}\n",
+          port.path,
+          strerror(errno)
+        );
+        return false;
+    }
+
+    port.pending.erase(0, size);
+    return true;
+}
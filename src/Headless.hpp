@@ -0,0 +1,116 @@
+#ifndef SESAMO_HEADLESS_HPP
+#define SESAMO_HEADLESS_HPP
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "CaptureWriter.hpp"
+#include "Reactor.hpp"
+#include "Serial.hpp"
+#include "Timeline.hpp"
+
+// Streams one or more serial ports to stdout or to files without any
+// window, GL context or GUI library, for capturing on machines without a
+// display. Everything is read by the same reactor the GUI uses; this side
+// only sleeps until the reactor reports activity, then formats and writes
+// out whatever arrived.
+class [[nodiscard]] Headless final
+{
+  public:
+    enum class Format : std::uint8_t
+    {
+        // Bytes exactly as received.
+        Raw,
+        // Received lines, optionally prefixed with port and timestamp.
+        Text,
+        // Sixteen bytes per line as hex, prefixed with their stream offset.
+        Hex,
+    };
+
+    struct Options
+    {
+        Reactor::Backend         reader_backend = Reactor::Backend::Epoll;
+        std::uint32_t            baud_rate      = 115200;
+        Format                   format         = Format::Text;
+        bool                     timestamps     = false;
+        // Reopen ports whose device went away instead of finishing once
+        // every port hung up.
+        bool                     reconnect      = false;
+        // CPU pinning, SCHED_FIFO and mlock for the reader thread.
+        Reactor::Tuning          reader_tuning;
+        // What every port does when this side cannot keep up, say with
+        // stdout going into a stalled pipe.
+        Serial::Buffering        buffering;
+        // Empty to write everything to stdout, otherwise one
+        // <output_directory>/<tty name>.log per port.
+        std::string              output_directory;
+        // Also record every port into this capture file if not empty.
+        std::string              capture;
+        // Chrome trace JSON written on SIGUSR1 and on exit, empty for none.
+        // Needs a build with SESAMO_TRACE.
+        std::string              trace;
+        std::vector<std::string> paths;
+    };
+
+    [[nodiscard]] static auto spawn(const Options &options)
+      -> std::unique_ptr<Headless>;
+
+    ~Headless();
+
+    Headless(const Headless &)            = delete;
+    Headless &operator=(const Headless &) = delete;
+    Headless(Headless &&)                 = delete;
+    Headless &operator=(Headless &&)      = delete;
+
+    // Captures until every port hung up for good or SIGINT/SIGTERM arrived,
+    // returns the process exit status. With `reconnect` a port that went
+    // away keeps being retried. SIGUSR1 dumps the trace if there is one.
+    int run();
+
+  private:
+    struct Port
+    {
+        std::string             path;
+        std::string             label;
+        std::shared_ptr<Serial> serial;
+        int                     output = -1;
+        Timeline                timeline;
+
+        // Bytes of the stream consumed so far and whether the next one
+        // starts a new output line (or, in hex, a row after a hole).
+        std::uint64_t offset     = 0;
+        bool          line_start = true;
+
+        // Latest line counters, empty while the driver reported none.
+        std::optional<Serial::LineCounters> counters;
+
+        std::vector<char> staging;
+        std::string       pending;
+    };
+
+    Headless(const Options &options, int wakeup_fd, int signal_fd);
+
+    constexpr static std::size_t HEX_ROW_SIZE = 16;
+
+    Options                        options;
+    // Several ports writing lines into stdout, only whole lines go out.
+    bool                           shared_output = false;
+    int                            wakeup_fd     = -1;
+    int                            signal_fd     = -1;
+    std::shared_ptr<Reactor>       reactor;
+    std::shared_ptr<CaptureWriter> capture;
+    std::vector<Port>              ports;
+
+    [[nodiscard]] bool open_ports();
+    [[nodiscard]] bool handle_signal();
+    void               drain(Port &port);
+    void               format_text(Port &port, std::span<const char> bytes);
+    void               format_hex(Port &port, std::span<const char> bytes);
+    void               prefix(Port &port);
+    [[nodiscard]] bool flush(Port &port, const bool everything);
+};
+
+#endif // SESAMO_HEADLESS_HPP
@@ -0,0 +1,276 @@
+#include "IoUring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <print>
+
+namespace
+{
+
+constexpr std::size_t MAX_OPCODES = 256;
+
+[[nodiscard]] int
+  io_uring_setup(const unsigned entries, io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+[[nodiscard]] int io_uring_enter(
+  const int      ring_fd,
+  const unsigned to_submit,
+  const unsigned min_complete,
+  const unsigned flags
+)
+{
+    return static_cast<int>(syscall(
+      __NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0
+    ));
+}
+
+[[nodiscard]] int io_uring_register(
+  const int      ring_fd,
+  const unsigned opcode,
+  void          *arg,
+  const unsigned nr_args
+)
+{
+    return static_cast<int>(
+      syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args)
+    );
+}
+
+template <typename T>
+[[nodiscard]] T *at_offset(void *base, const std::size_t offset)
+{
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+} // namespace
+
+auto IoUring::create(const unsigned entries) -> std::unique_ptr<IoUring>
+{
+    io_uring_params params{};
+    const auto      ring_fd = io_uring_setup(entries, &params);
+    if (ring_fd < 0) {
+        std::print(
+          stderr, "[WARNING] io_uring is not available: {}\n", strerror(errno)
+        );
+        return nullptr;
+    }
+
+    auto ring = std::unique_ptr<IoUring>(new IoUring(ring_fd));
+
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0) {
+        std::print(stderr, "[WARNING] io_uring is too old to be used\n");
+        return nullptr;
+    }
+
+    ring->ring_memory_size = std::max(
+      params.sq_off.array + (params.sq_entries * sizeof(unsigned)),
+      params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe))
+    );
+    ring->ring_memory = mmap(
+      nullptr,
+      ring->ring_memory_size,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      ring_fd,
+      IORING_OFF_SQ_RING
+    );
+    if (ring->ring_memory == MAP_FAILED) {
+        ring->ring_memory = nullptr;
+        std::print(
+          stderr, "[ERROR] failed to map io_uring rings: {}\n", strerror(errno)
+        );
+        return nullptr;
+    }
+
+    ring->sqe_memory_size = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqe_memory      = mmap(
+      nullptr,
+      ring->sqe_memory_size,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      ring_fd,
+      IORING_OFF_SQES
+    );
+    if (ring->sqe_memory == MAP_FAILED) {
+        ring->sqe_memory = nullptr;
+        std::print(
+          stderr,
+          "[ERROR] failed to map io_uring submission entries: {}\n",
+          strerror(errno)
+        );
+        return nullptr;
+    }
+
+    auto *base     = ring->ring_memory;
+    ring->sq_head  = at_offset<unsigned>(base, params.sq_off.head);
+    ring->sq_tail  = at_offset<unsigned>(base, params.sq_off.tail);
+    ring->sq_mask  = *at_offset<unsigned>(base, params.sq_off.ring_mask);
+    ring->sq_array = at_offset<unsigned>(base, params.sq_off.array);
+    ring->sqes     = static_cast<io_uring_sqe *>(ring->sqe_memory);
+    ring->cq_head  = at_offset<unsigned>(base, params.cq_off.head);
+    ring->cq_tail  = at_offset<unsigned>(base, params.cq_off.tail);
+    ring->cq_mask  = *at_offset<unsigned>(base, params.cq_off.ring_mask);
+    ring->cqes     = at_offset<io_uring_cqe>(base, params.cq_off.cqes);
+    ring->sq_local_tail = *ring->sq_tail;
+
+    const auto probe_size =
+      sizeof(io_uring_probe) + (MAX_OPCODES * sizeof(io_uring_probe_op));
+    auto probe_memory = std::make_unique<std::uint8_t[]>(probe_size);
+    auto *probe       = reinterpret_cast<io_uring_probe *>(probe_memory.get());
+    ring->supported_ops = std::make_unique<std::uint8_t[]>(MAX_OPCODES);
+    if (io_uring_register(
+          ring_fd, IORING_REGISTER_PROBE, probe, MAX_OPCODES
+        )
+        == 0) {
+        for (std::size_t op = 0; op < probe->ops_len; ++op) {
+            ring->supported_ops[op] =
+              (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0 ? 1 : 0;
+        }
+    }
+
+    return ring;
+}
+
+IoUring::IoUring(int ring_fd)
+  : ring_fd(ring_fd)
+{}
+
+IoUring::~IoUring()
+{
+    if (buffer_ring != nullptr) { munmap(buffer_ring, buffer_ring_size); }
+    if (sqe_memory != nullptr) { munmap(sqe_memory, sqe_memory_size); }
+    if (ring_memory != nullptr) { munmap(ring_memory, ring_memory_size); }
+    if (ring_fd >= 0) { ::close(ring_fd); }
+}
+
+bool IoUring::supports(const std::uint8_t opcode) const
+{
+    return supported_ops[opcode] != 0;
+}
+
+io_uring_sqe *IoUring::get_sqe()
+{
+    if (sq_local_tail - load_acquire(sq_head) > sq_mask) { return nullptr; }
+
+    const auto index = sq_local_tail & sq_mask;
+    sq_array[index]  = index;
+    ++sq_local_tail;
+    ++sq_pending;
+
+    auto *sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUring::submit_and_wait(const unsigned wait_nr)
+{
+    store_release(sq_tail, sq_local_tail);
+
+    const auto submitted =
+      io_uring_enter(ring_fd, sq_pending, wait_nr, IORING_ENTER_GETEVENTS);
+    if (submitted < 0) { return -errno; }
+
+    sq_pending -= std::min(sq_pending, static_cast<unsigned>(submitted));
+    return submitted;
+}
+
+bool IoUring::register_buffer_ring(
+  const std::uint16_t count,
+  const std::uint32_t size
+)
+{
+    // The kernel wants a power of two number of entries.
+    if (count == 0 || (count & (count - 1)) != 0) { return false; }
+
+    buffer_ring_size = count * sizeof(io_uring_buf);
+    void *memory     = mmap(
+      nullptr,
+      buffer_ring_size,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0
+    );
+    if (memory == MAP_FAILED) {
+        std::print(
+          stderr,
+          "[ERROR] failed to allocate io_uring buffer ring: {}\n",
+          strerror(errno)
+        );
+        return false;
+    }
+    buffer_ring = static_cast<io_uring_buf_ring *>(memory);
+
+    io_uring_buf_reg registration{};
+    registration.ring_addr    = reinterpret_cast<std::uint64_t>(buffer_ring);
+    registration.ring_entries = count;
+    registration.bgid         = BUFFER_GROUP;
+    if (io_uring_register(
+          ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1
+        )
+        < 0) {
+        std::print(
+          stderr,
+          "[WARNING] failed to register io_uring buffer ring: {}\n",
+          strerror(errno)
+        );
+        munmap(buffer_ring, buffer_ring_size);
+        buffer_ring = nullptr;
+        return false;
+    }
+
+    buffer_count  = count;
+    buffer_size   = size;
+    buffer_memory = std::make_unique_for_overwrite<char[]>(
+      static_cast<std::size_t>(count) * size
+    );
+    for (std::uint16_t id = 0; id < count; ++id) { recycle_buffer(id); }
+
+    return true;
+}
+
+std::span<const char>
+  IoUring::buffer(const std::uint16_t id, const std::size_t length) const
+{
+    return { buffer_memory.get() + (static_cast<std::size_t>(id) * buffer_size),
+             std::min<std::size_t>(length, buffer_size) };
+}
+
+void IoUring::recycle_buffer(const std::uint16_t id)
+{
+    // The ring tail overlays the reserved field of the first entry.
+    std::atomic_ref<std::uint16_t> tail(buffer_ring->tail);
+    const auto current = tail.load(std::memory_order_relaxed);
+
+    // Index the entries by hand, in C++ the uapi flexible array member may
+    // be placed after a padded empty struct rather than at offset zero.
+    auto *entries = reinterpret_cast<io_uring_buf *>(buffer_ring);
+    auto &entry   = entries[current & (buffer_count - 1)];
+    entry.addr  = reinterpret_cast<std::uint64_t>(
+      buffer_memory.get() + (static_cast<std::size_t>(id) * buffer_size)
+    );
+    entry.len = buffer_size;
+    entry.bid = id;
+
+    tail.store(
+      static_cast<std::uint16_t>(current + 1), std::memory_order_release
+    );
+}
+
+unsigned IoUring::load_acquire(unsigned *value)
+{
+    return std::atomic_ref<unsigned>(*value).load(std::memory_order_acquire);
+}
+
+void IoUring::store_release(unsigned *value, const unsigned desired)
+{
+    std::atomic_ref<unsigned>(*value).store(desired, std::memory_order_release);
+}
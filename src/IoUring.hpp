@@ -0,0 +1,113 @@
+#ifndef SESAMO_IO_URING_HPP
+#define SESAMO_IO_URING_HPP
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include <linux/io_uring.h>
+
+// Thin wrapper around the raw io_uring syscalls, just enough for the serial
+// reader: a submission/completion queue pair plus one ring of provided
+// buffers registered with the kernel that multishot reads pick from.
+class [[nodiscard]] IoUring final
+{
+  public:
+    // Not every uapi header knows about multishot reads (added in 6.7) yet,
+    // the opcode itself is part of the stable ABI.
+    constexpr static std::uint8_t OP_READ_MULTISHOT = 49;
+
+    constexpr static std::uint16_t BUFFER_GROUP = 0;
+
+    // Returns nullptr when the kernel does not support io_uring (or it has
+    // been disabled through the io_uring_disabled sysctl).
+    [[nodiscard]] static auto create(const unsigned entries)
+      -> std::unique_ptr<IoUring>;
+
+    ~IoUring();
+
+    IoUring(const IoUring &)            = delete;
+    IoUring &operator=(const IoUring &) = delete;
+    IoUring(IoUring &&)                 = delete;
+    IoUring &operator=(IoUring &&)      = delete;
+
+    [[nodiscard]] bool supports(const std::uint8_t opcode) const;
+
+    // Returns a zeroed submission entry or nullptr if the queue is full.
+    [[nodiscard]] io_uring_sqe *get_sqe();
+
+    // Submits everything queued so far and waits for at least `wait_nr`
+    // completions. Returns the io_uring_enter result or -errno.
+    int submit_and_wait(const unsigned wait_nr);
+
+    // Invokes `handler(const io_uring_cqe &)` for every available completion
+    // and releases them back to the kernel, returns how many were seen.
+    template <typename Handler>
+    unsigned for_each_cqe(Handler &&handler)
+    {
+        auto       head = load_acquire(cq_head);
+        const auto tail = load_acquire(cq_tail);
+
+        unsigned seen = 0;
+        for (; head != tail; ++head, ++seen) {
+            handler(cqes[head & cq_mask]);
+        }
+
+        store_release(cq_head, head);
+        return seen;
+    }
+
+    [[nodiscard]] bool register_buffer_ring(
+      const std::uint16_t count,
+      const std::uint32_t size
+    );
+
+    [[nodiscard]] std::span<const char>
+      buffer(const std::uint16_t id, const std::size_t length) const;
+
+    // All provided buffers back to back, e.g. to mlock() them.
+    [[nodiscard]] std::span<const char> buffers() const
+    {
+        return { buffer_memory.get(),
+                 static_cast<std::size_t>(buffer_count) * buffer_size };
+    }
+
+    // Hands a provided buffer back to the kernel once its data was consumed.
+    void recycle_buffer(const std::uint16_t id);
+
+  private:
+    explicit IoUring(int ring_fd);
+
+    [[nodiscard]] static unsigned load_acquire(unsigned *value);
+    static void store_release(unsigned *value, const unsigned desired);
+
+    int ring_fd = -1;
+
+    void       *ring_memory      = nullptr;
+    std::size_t ring_memory_size = 0;
+    void       *sqe_memory       = nullptr;
+    std::size_t sqe_memory_size  = 0;
+
+    unsigned     *sq_head  = nullptr;
+    unsigned     *sq_tail  = nullptr;
+    unsigned      sq_mask  = 0;
+    unsigned     *sq_array = nullptr;
+    io_uring_sqe *sqes     = nullptr;
+    unsigned      sq_local_tail = 0;
+    unsigned      sq_pending    = 0;
+
+    unsigned     *cq_head = nullptr;
+    unsigned     *cq_tail = nullptr;
+    unsigned      cq_mask = 0;
+    io_uring_cqe *cqes    = nullptr;
+
+    std::unique_ptr<std::uint8_t[]> supported_ops;
+
+    io_uring_buf_ring      *buffer_ring        = nullptr;
+    std::size_t             buffer_ring_size   = 0;
+    std::uint16_t           buffer_count       = 0;
+    std::uint32_t           buffer_size        = 0;
+    std::unique_ptr<char[]> buffer_memory;
+};
+
+#endif // SESAMO_IO_URING_HPP
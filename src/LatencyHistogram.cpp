@@ -0,0 +1,78 @@
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace
+{
+
+// Buckets per power of two, as a shift.
+constexpr unsigned SUB_BITS = 2;
+constexpr unsigned SUB      = 1U << SUB_BITS;
+
+} // namespace
+
+std::size_t
+  LatencyHistogram::bucket_of(const std::chrono::nanoseconds latency) noexcept
+{
+    const auto micros = static_cast<std::uint64_t>(std::max<std::int64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count(),
+      0
+    ));
+
+    // Below 4 us every microsecond gets its own bucket, above that the two
+    // bits under the leading one pick one of four per power of two.
+    if (micros < SUB) { return static_cast<std::size_t>(micros); }
+    const auto exponent = static_cast<unsigned>(std::bit_width(micros)) - 1;
+    const auto sub = (micros >> (exponent - SUB_BITS)) & (SUB - 1);
+    const auto bucket =
+      (static_cast<std::size_t>(exponent - SUB_BITS + 1) * SUB) + sub;
+    return std::min(bucket, BUCKETS - 1);
+}
+
+std::chrono::nanoseconds
+  LatencyHistogram::lower_bound(const std::size_t bucket) noexcept
+{
+    if (bucket < SUB) { return std::chrono::microseconds(bucket); }
+    const auto exponent = (bucket / SUB) - 1 + SUB_BITS;
+    const auto sub      = bucket % SUB;
+    return std::chrono::microseconds((SUB + sub) << (exponent - SUB_BITS));
+}
+
+void LatencyHistogram::record(
+  const std::chrono::nanoseconds latency, const std::uint64_t weight
+) noexcept
+{
+    counts[bucket_of(latency)] += weight;
+    total                      += weight;
+    largest                     = std::max(largest, latency);
+}
+
+void LatencyHistogram::clear() noexcept
+{
+    counts.fill(0);
+    total   = 0;
+    largest = std::chrono::nanoseconds(0);
+}
+
+std::chrono::nanoseconds
+  LatencyHistogram::percentile(const double which) const noexcept
+{
+    if (total == 0) { return std::chrono::nanoseconds(0); }
+
+    const auto rank = static_cast<std::uint64_t>(
+      std::ceil((which / 100.0) * static_cast<double>(total))
+    );
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += counts[bucket];
+        if (seen >= std::max<std::uint64_t>(rank, 1)) {
+            // The largest sample is a tighter bound for the top bucket.
+            return bucket + 1 < BUCKETS
+                     ? std::min(lower_bound(bucket + 1), largest)
+                     : largest;
+        }
+    }
+    return largest;
+}
@@ -0,0 +1,55 @@
+#ifndef SESAMO_LATENCY_HISTOGRAM_HPP
+#define SESAMO_LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Distribution of latencies in fixed log-linear buckets, four per power of
+// two of microseconds (so within 25% of the true value), from 1 us up to
+// about half a minute. Recording is a few integer operations and never
+// allocates, whatever the rate.
+class [[nodiscard]] LatencyHistogram final
+{
+  public:
+    constexpr static std::size_t BUCKETS = 96;
+
+    void record(
+      const std::chrono::nanoseconds latency, const std::uint64_t weight = 1
+    ) noexcept;
+    void clear() noexcept;
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return total; }
+
+    // Upper bound of the bucket holding the requested percentile (0-100),
+    // zero while empty.
+    [[nodiscard]] std::chrono::nanoseconds
+      percentile(const double which) const noexcept;
+
+    [[nodiscard]] std::chrono::nanoseconds max() const noexcept
+    {
+        return largest;
+    }
+
+    [[nodiscard]] const std::array<std::uint64_t, BUCKETS> &
+      buckets() const noexcept
+    {
+        return counts;
+    }
+
+    // The latencies `bucket` counts, from `lower_bound(bucket)` up to but
+    // excluding `lower_bound(bucket + 1)`.
+    [[nodiscard]] static std::chrono::nanoseconds
+      lower_bound(const std::size_t bucket) noexcept;
+
+  private:
+    std::array<std::uint64_t, BUCKETS> counts{};
+    std::uint64_t                      total = 0;
+    std::chrono::nanoseconds           largest{ 0 };
+
+    [[nodiscard]] static std::size_t
+      bucket_of(const std::chrono::nanoseconds latency) noexcept;
+};
+
+#endif // SESAMO_LATENCY_HISTOGRAM_HPP
@@ -0,0 +1,77 @@
+#include "Options.hpp"
+
+#include <limits>
+#include <print>
+
+namespace cli
+{
+
+std::optional<int> parse_priority(const std::string_view value)
+{
+    constexpr int MIN_PRIORITY = 1;
+    constexpr int MAX_PRIORITY = 99;
+
+    const auto priority = parse_number<int>(value);
+    if (priority && (*priority < MIN_PRIORITY || *priority > MAX_PRIORITY)) {
+        std::print(
+          stderr,
+          "[ERROR] --reader-priority must be between {} and {}\n",
+          MIN_PRIORITY,
+          MAX_PRIORITY
+        );
+        return std::nullopt;
+    }
+    return priority;
+}
+
+std::optional<std::uint64_t> parse_mebibytes(const std::string_view value)
+{
+    constexpr std::uint64_t MEBIBYTE = 1024 * 1024;
+    constexpr auto          MAX_MEBIBYTES =
+      std::numeric_limits<std::uint64_t>::max() / MEBIBYTE;
+
+    const auto mebibytes = parse_number<std::uint64_t>(value);
+    if (!mebibytes || *mebibytes == 0) { return std::nullopt; }
+    if (*mebibytes > MAX_MEBIBYTES) {
+        std::print(
+          stderr, "[ERROR] {} MiB is more than {} MiB\n", value, MAX_MEBIBYTES
+        );
+        return std::nullopt;
+    }
+    return *mebibytes * MEBIBYTE;
+}
+
+std::optional<bool>
+  parse_buffering(const std::string_view arg, Serial::Buffering &buffering)
+{
+    constexpr std::string_view BACKPRESSURE = "--backpressure=";
+    constexpr std::string_view READ_BUFFER  = "--read-buffer=";
+    constexpr std::string_view SPILL_DIR    = "--spill-dir=";
+    constexpr std::string_view SPILL_LIMIT  = "--spill-limit=";
+
+    if (arg.starts_with(BACKPRESSURE)) {
+        const auto policy =
+          Serial::parse_backpressure(arg.substr(BACKPRESSURE.size()));
+        if (policy) { buffering.policy = *policy; }
+        return policy.has_value();
+    }
+    if (arg.starts_with(READ_BUFFER)) {
+        const auto capacity = parse_mebibytes(arg.substr(READ_BUFFER.size()));
+        if (capacity) {
+            buffering.capacity = static_cast<std::size_t>(*capacity);
+        }
+        return capacity.has_value();
+    }
+    if (arg.starts_with(SPILL_DIR)) {
+        buffering.spill_directory = arg.substr(SPILL_DIR.size());
+        return true;
+    }
+    if (arg.starts_with(SPILL_LIMIT)) {
+        const auto limit = parse_mebibytes(arg.substr(SPILL_LIMIT.size()));
+        if (limit) { buffering.spill_limit = *limit; }
+        return limit.has_value();
+    }
+    return std::nullopt;
+}
+
+} // namespace cli
@@ -0,0 +1,45 @@
+#ifndef SESAMO_OPTIONS_HPP
+#define SESAMO_OPTIONS_HPP
+
+#include "Serial.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Command line values both sesamo and sesamo_headless take. A value that
+// is out of range is reported on stderr, one that does not parse at all
+// is left to the caller's usage message.
+namespace cli
+{
+
+// Parses all of `value` as a number, nullopt if anything else is there.
+template <typename Number>
+[[nodiscard]] std::optional<Number> parse_number(const std::string_view value)
+{
+    Number number{};
+    const auto [end, error] =
+      std::from_chars(value.data(), value.data() + value.size(), number);
+    if (error != std::errc{} || end != value.data() + value.size()) {
+        return std::nullopt;
+    }
+    return number;
+}
+
+// Parses the `--reader-priority=` value, a SCHED_FIFO priority.
+[[nodiscard]] std::optional<int> parse_priority(std::string_view value);
+
+// Parses a `--read-buffer=`/`--spill-limit=` value in MiB into bytes, it
+// must not be 0 and the bytes have to fit in 64 bits.
+[[nodiscard]] std::optional<std::uint64_t>
+  parse_mebibytes(std::string_view value);
+
+// Applies the buffering flags to `buffering`, false if `arg` is one of them
+// but its value is not valid and nullopt if it is none of them.
+[[nodiscard]] std::optional<bool>
+  parse_buffering(std::string_view arg, Serial::Buffering &buffering);
+
+} // namespace cli
+
+#endif // SESAMO_OPTIONS_HPP
@@ -0,0 +1,930 @@
+#include "Reactor.hpp"
+#include "Serial.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <span>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+// Stack below the frame tune() runs in that gets locked too, room for the
+// calls a read makes from the loop.
+constexpr std::uintptr_t STACK_HEADROOM = 16 * 1024;
+
+// mlock()s `memory`, false (after printing why) if the kernel refused.
+[[nodiscard]] bool lock(const std::span<const char> memory, const char *what)
+{
+    if (memory.empty() || mlock(memory.data(), memory.size()) == 0) {
+        return true;
+    }
+
+    const auto error = errno;
+    rlimit     limit{};
+    getrlimit(RLIMIT_MEMLOCK, &limit);
+    std::print(
+      stderr,
+      "[WARNING] failed to lock {} in memory: {} (RLIMIT_MEMLOCK is {})\n",
+      what,
+      strerror(error),
+      limit.rlim_cur == RLIM_INFINITY
+        ? std::string("unlimited")
+        : std::format("{} KiB", limit.rlim_cur / 1024)
+    );
+    return false;
+}
+
+} // namespace
+
+auto Reactor::spawn(
+  const Backend         backend,
+  std::function<void()> on_activity
+) -> std::shared_ptr<Reactor>
+{
+    const auto wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeup_fd < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to create reactor wakeup eventfd: {}\n",
+          strerror(errno)
+        );
+        return nullptr;
+    }
+
+    const auto retry_fd =
+      timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (retry_fd < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to create reactor retry timerfd: {}\n",
+          strerror(errno)
+        );
+        ::close(wakeup_fd);
+        return nullptr;
+    }
+
+    const auto counter_fd =
+      timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (counter_fd < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to create reactor counter timerfd: {}\n",
+          strerror(errno)
+        );
+        ::close(retry_fd);
+        ::close(wakeup_fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<IoUring> uring;
+    if (backend == Backend::IoUring) {
+        uring = IoUring::create(IO_URING_QUEUE_DEPTH);
+        if (uring && !uring->supports(IoUring::OP_READ_MULTISHOT)) {
+            std::print(
+              stderr, "[WARNING] kernel does not support multishot reads\n"
+            );
+            uring.reset();
+        }
+        if (uring
+            && !uring->register_buffer_ring(
+              IO_URING_BUFFER_COUNT, IO_URING_BUFFER_SIZE
+            )) {
+            uring.reset();
+        }
+        if (!uring) {
+            std::print(stderr, "[WARNING] falling back to the epoll reader\n");
+        }
+    }
+
+    auto epoll_fd = -1;
+    if (!uring) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            std::print(
+              stderr,
+              "[ERROR] failed to create epoll instance: {}\n",
+              strerror(errno)
+            );
+            ::close(counter_fd);
+            ::close(retry_fd);
+            ::close(wakeup_fd);
+            return nullptr;
+        }
+
+        epoll_event wakeup{};
+        wakeup.events   = EPOLLIN;
+        wakeup.data.u64 = WAKEUP_ID;
+        epoll_event retry{};
+        retry.events   = EPOLLIN;
+        retry.data.u64 = RETRY_ID;
+        epoll_event counter{};
+        counter.events   = EPOLLIN;
+        counter.data.u64 = COUNTERS_ID;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &wakeup) < 0
+            || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, retry_fd, &retry) < 0
+            || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, counter_fd, &counter) < 0) {
+            std::print(
+              stderr,
+              "[ERROR] failed to register reactor wakeup fds: {}\n",
+              strerror(errno)
+            );
+            ::close(epoll_fd);
+            ::close(counter_fd);
+            ::close(retry_fd);
+            ::close(wakeup_fd);
+            return nullptr;
+        }
+    }
+
+    // The last reference may go on the reactor thread itself, say one a
+    // port locked for a moment. That thread cannot join itself and must not
+    // go back to a loop whose members are gone, so another thread destroys
+    // the reactor once the loop stopped.
+    auto reactor = std::shared_ptr<Reactor>(
+      new Reactor(
+        epoll_fd,
+        wakeup_fd,
+        retry_fd,
+        counter_fd,
+        std::move(uring),
+        std::move(on_activity)
+      ),
+      [](Reactor *instance) {
+          if (std::this_thread::get_id() == instance->thread.get_id()) {
+              std::thread([instance] { delete instance; }).detach();
+          } else {
+              delete instance;
+          }
+      }
+    );
+    reactor->thread = std::thread(
+      reactor->uring ? &Reactor::run_io_uring : &Reactor::run_epoll,
+      reactor.get()
+    );
+    pthread_getcpuclockid(
+      reactor->thread.native_handle(), &reactor->cpu_clock
+    );
+
+    return reactor;
+}
+
+Reactor::Reactor(
+  int                      epoll_fd,
+  int                      wakeup_fd,
+  int                      retry_fd,
+  int                      counter_fd,
+  std::unique_ptr<IoUring> uring,
+  std::function<void()>    on_activity
+)
+  : epoll_fd(epoll_fd),
+    wakeup_fd(wakeup_fd),
+    retry_fd(retry_fd),
+    counter_fd(counter_fd),
+    uring(std::move(uring)),
+    stop(false),
+    running(true),
+    on_activity(std::move(on_activity)),
+    activity_pending(false),
+    wakeups(0),
+    syscalls(0)
+{}
+
+Reactor::~Reactor()
+{
+    stop.store(true, std::memory_order_relaxed);
+    wake();
+
+    // Never on the reactor thread, see spawn().
+    if (thread.joinable()) { thread.join(); }
+
+    // Ports still attached close their fd on their own once released, they
+    // can no longer reach us through their weak reference.
+    ports.clear();
+    retrying.clear();
+
+    if (epoll_fd >= 0) { ::close(epoll_fd); }
+    if (wakeup_fd >= 0) { ::close(wakeup_fd); }
+    if (retry_fd >= 0) { ::close(retry_fd); }
+    if (counter_fd >= 0) { ::close(counter_fd); }
+}
+
+bool Reactor::attach(const std::shared_ptr<Serial> &serial)
+{
+    if (std::this_thread::get_id() == thread.get_id()) {
+        return add_port(serial);
+    }
+
+    Command command;
+    command.attach = serial;
+    return post(std::move(command));
+}
+
+void Reactor::detach(const Serial &serial)
+{
+    if (std::this_thread::get_id() == thread.get_id()) {
+        remove_port(serial);
+        return;
+    }
+
+    Command command;
+    command.detach = &serial;
+    [[maybe_unused]] const auto _ = post(std::move(command));
+}
+
+bool Reactor::execute(std::function<void()> task)
+{
+    if (std::this_thread::get_id() == thread.get_id()) {
+        task();
+        return true;
+    }
+
+    Command command;
+    command.task = std::move(task);
+    return post(std::move(command));
+}
+
+auto Reactor::tune(const Tuning &tuning) -> Tuned
+{
+    Tuned      tuned;
+    const auto applied = execute([this, &tuning, &tuned] {
+        const auto self = pthread_self();
+
+        if (tuning.cpu) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            auto error = EINVAL;
+            if (*tuning.cpu < CPU_SETSIZE) {
+                CPU_SET(*tuning.cpu, &cpus);
+                error = pthread_setaffinity_np(self, sizeof(cpus), &cpus);
+            }
+            if (error != 0) {
+                std::print(
+                  stderr,
+                  "[WARNING] failed to pin the reader thread to cpu {}: {}\n",
+                  *tuning.cpu,
+                  strerror(error)
+                );
+            }
+            tuned.pinned = error == 0;
+        }
+
+        if (tuning.priority) {
+            sched_param parameters{};
+            parameters.sched_priority = *tuning.priority;
+            const auto error =
+              pthread_setschedparam(self, SCHED_FIFO, &parameters);
+            if (error != 0) {
+                std::print(
+                  stderr,
+                  "[WARNING] failed to raise the reader thread to SCHED_FIFO "
+                  "{}: {}\n",
+                  *tuning.priority,
+                  strerror(error)
+                );
+            }
+            tuned.realtime = error == 0;
+        }
+
+        if (tuning.lock_memory) {
+            lock_memory = true;
+            auto locked = lock_stack();
+            if (uring) {
+                locked = lock(uring->buffers(), "the io_uring buffers")
+                         && locked;
+                if (locked) { locked_bytes += uring->buffers().size(); }
+            }
+            for (const auto &[_, serial] : ports) {
+                locked = lock_port(*serial) && locked;
+            }
+            for (const auto &[_, serial] : retrying) {
+                locked = lock_port(*serial) && locked;
+            }
+            tuned.locked       = locked;
+            tuned.locked_bytes = locked_bytes;
+        }
+    });
+
+    return applied ? tuned : Tuned{};
+}
+
+std::string Reactor::describe(const Tuning &tuning, const Tuned &tuned)
+{
+    std::string line;
+    const auto  append = [&line](const std::string &part) {
+        line += line.empty() ? part : ", " + part;
+    };
+
+    if (tuning.cpu) {
+        append(
+          tuned.pinned ? std::format("cpu {}", *tuning.cpu) : "not pinned"
+        );
+    }
+    if (tuning.priority) {
+        append(
+          tuned.realtime ? std::format("SCHED_FIFO {}", *tuning.priority)
+                         : "SCHED_OTHER"
+        );
+    }
+    if (tuning.lock_memory) {
+        append(tuned.locked ? "buffers locked" : "buffers not locked");
+    }
+    return line.empty() ? "default scheduling" : line;
+}
+
+std::chrono::nanoseconds Reactor::cpu_time() const
+{
+    timespec time{};
+    if (clock_gettime(cpu_clock, &time) != 0) { return {}; }
+
+    return std::chrono::seconds(time.tv_sec)
+           + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+void Reactor::wake() const
+{
+    const std::uint64_t one = 1;
+    // NOLINTNEXTLINE
+    [[maybe_unused]] const auto _ = ::write(wakeup_fd, &one, sizeof(one));
+}
+
+bool Reactor::post(Command command)
+{
+    auto result = command.done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex);
+        if (!running) { return false; }
+        commands.push_back(std::move(command));
+    }
+
+    wake();
+    return result.get();
+}
+
+void Reactor::apply_commands()
+{
+    std::uint64_t counter = 0;
+    // NOLINTNEXTLINE
+    [[maybe_unused]] const auto _ =
+      ::read(wakeup_fd, &counter, sizeof(counter));
+    syscalls.fetch_add(1, std::memory_order_relaxed);
+
+    std::vector<Command> pending;
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex);
+        pending.swap(commands);
+    }
+
+    for (auto &command : pending) {
+        if (command.attach) {
+            command.done.set_value(add_port(command.attach));
+        } else if (command.detach != nullptr) {
+            remove_port(*command.detach);
+            command.done.set_value(true);
+        } else {
+            command.task();
+            command.done.set_value(true);
+        }
+    }
+}
+
+void Reactor::shutdown()
+{
+    std::vector<Command> pending;
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex);
+        running = false;
+        pending.swap(commands);
+    }
+
+    for (auto &command : pending) { command.done.set_value(false); }
+}
+
+bool Reactor::add_port(const std::shared_ptr<Serial> &serial)
+{
+    const auto id      = next_id++;
+    serial->reactor_id = id;
+
+    if (uring) {
+        arm_read(id, serial->fd);
+    } else {
+        epoll_event event{};
+        event.events   = EPOLLIN;
+        event.data.u64 = id;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, serial->fd, &event) < 0) {
+            std::print(
+              stderr,
+              "[ERROR] failed to register serial port with epoll: {}\n",
+              strerror(errno)
+            );
+            return false;
+        }
+    }
+
+    serial->paused = false;
+    ports.emplace(id, serial);
+    if (serial->has_counters() && !polling) {
+        poll_every(Serial::COUNTER_INTERVAL);
+    }
+    // A port that could not be locked is still read, tune() reported why.
+    if (lock_memory) { [[maybe_unused]] const auto _ = lock_port(*serial); }
+    return true;
+}
+
+bool Reactor::lock_port(Serial &serial)
+{
+    // Reopened ports keep their rings.
+    if (serial.locked) { return true; }
+
+    const auto rings = {
+        serial.read_buffer->storage(),
+        serial.arrivals->storage(),
+        serial.gaps->storage(),
+        serial.samples->storage(),
+    };
+    for (const auto ring : rings) {
+        if (!lock(ring, "the serial port buffers")) { return false; }
+    }
+    for (const auto ring : rings) { locked_bytes += ring.size(); }
+    serial.locked = true;
+    return true;
+}
+
+bool Reactor::lock_stack()
+{
+    // From a bit below this frame up to where the thread started, that
+    // covers the loop's frames and the epoll overflow buffer among them.
+    pthread_attr_t attributes;
+    if (pthread_getattr_np(pthread_self(), &attributes) != 0) { return false; }
+    void       *stack = nullptr;
+    std::size_t size  = 0;
+    pthread_attr_getstack(&attributes, &stack, &size);
+    pthread_attr_destroy(&attributes);
+
+    const auto page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto low  = reinterpret_cast<std::uintptr_t>(stack);
+    const auto high = low + size;
+    const auto here = std::max(
+      low,
+      (reinterpret_cast<std::uintptr_t>(__builtin_frame_address(0))
+       - STACK_HEADROOM)
+        & ~(page - 1)
+    );
+
+    // NOLINTNEXTLINE(performance-no-int-to-ptr)
+    const std::span memory(reinterpret_cast<const char *>(here), high - here);
+    if (!lock(memory, "the reader thread stack")) { return false; }
+    locked_bytes += memory.size();
+    return true;
+}
+
+void Reactor::remove_port(const Serial &serial)
+{
+    // Without an fd there is nothing to unregister, a late timer finds the
+    // port gone.
+    if (const auto waiting = retrying.find(serial.reactor_id);
+        waiting != retrying.end()) {
+        const auto released = std::move(waiting->second);
+        retrying.erase(waiting);
+        return;
+    }
+
+    const auto port = ports.find(serial.reactor_id);
+    if (port == ports.end()) { return; }
+
+    if (uring) {
+        // Completions that race with the cancellation carry an id that is
+        // no longer in `ports` and are simply dropped. The cancel must not
+        // be skipped, the armed read holds on to the tty otherwise.
+        auto *sqe      = next_sqe();
+        sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+        sqe->addr      = serial.reactor_id;
+        sqe->user_data = CANCEL_ID;
+    } else {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, serial.fd, nullptr);
+    }
+
+    // Releasing the last reference closes the port, which calls back into
+    // detach(), so take it out of the map before letting go of it.
+    const auto released = std::move(port->second);
+    ports.erase(port);
+}
+
+void Reactor::drop_port(const std::uint64_t id)
+{
+    const auto port = ports.find(id);
+    if (port == ports.end()) { return; }
+
+    auto released = std::move(port->second);
+    ports.erase(port);
+
+    if (!uring) { epoll_ctl(epoll_fd, EPOLL_CTL_DEL, released->fd, nullptr); }
+
+    // A failed io_uring read is not re-armed, so once the fd is closed
+    // nothing refers to it any more.
+    if (released->reconnect_enabled.load(std::memory_order_relaxed)) {
+        released->lose();
+        retrying.emplace(id, std::move(released));
+        schedule_retries();
+        return;
+    }
+    released->connected.store(false, std::memory_order_relaxed);
+}
+
+void Reactor::retry_ports()
+{
+    std::uint64_t expirations = 0;
+    // NOLINTNEXTLINE
+    [[maybe_unused]] const auto _ =
+      ::read(retry_fd, &expirations, sizeof(expirations));
+    syscalls.fetch_add(1, std::memory_order_relaxed);
+
+    const auto                           now = Serial::Clock::now();
+    std::vector<std::shared_ptr<Serial>> resumed;
+    for (auto port = retrying.begin(); port != retrying.end();) {
+        if (port->second->retry_at > now || !port->second->reopen()) {
+            ++port;
+            continue;
+        }
+        resumed.push_back(std::move(port->second));
+        port = retrying.erase(port);
+    }
+
+    // Back under a fresh id, completions still in flight for the old fd
+    // must not end up in the new one.
+    for (auto &serial : resumed) {
+        if (add_port(serial)) { continue; }
+        serial->lose();
+        retrying.emplace(serial->reactor_id, std::move(serial));
+    }
+
+    schedule_retries();
+    if (!resumed.empty()) { signal_activity(); }
+}
+
+void Reactor::schedule_retries()
+{
+    // All zero disarms the timer.
+    itimerspec timer{};
+    if (!retrying.empty()) {
+        auto next = Serial::Clock::time_point::max();
+        for (const auto &[_, serial] : retrying) {
+            next = std::min(next, serial->retry_at);
+        }
+
+        const auto since = next.time_since_epoch();
+        const auto seconds =
+          std::chrono::duration_cast<std::chrono::seconds>(since);
+        timer.it_value.tv_sec  = seconds.count();
+        timer.it_value.tv_nsec = std::chrono::duration_cast<
+                                   std::chrono::nanoseconds>(since - seconds)
+                                   .count();
+    }
+
+    timerfd_settime(retry_fd, TFD_TIMER_ABSTIME, &timer, nullptr);
+    syscalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool Reactor::poll_counters()
+{
+    std::uint64_t expirations = 0;
+    // NOLINTNEXTLINE
+    [[maybe_unused]] const auto _ =
+      ::read(counter_fd, &expirations, sizeof(expirations));
+    syscalls.fetch_add(1, std::memory_order_relaxed);
+
+    auto counted = false;
+    auto moved   = false;
+    for (const auto &[id, serial] : ports) {
+        if (!serial->has_counters()) { continue; }
+        counted = true;
+        moved   = serial->poll_counters() || moved;
+        syscalls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Nothing left to poll, an idle reactor should not tick.
+    if (!counted) { poll_every(std::chrono::milliseconds(0)); }
+    return moved;
+}
+
+void Reactor::poll_every(const std::chrono::milliseconds interval)
+{
+    // All zero disarms the timer.
+    const auto seconds =
+      std::chrono::duration_cast<std::chrono::seconds>(interval);
+    itimerspec timer{};
+    timer.it_interval.tv_sec  = seconds.count();
+    timer.it_interval.tv_nsec =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(interval - seconds)
+        .count();
+    timer.it_value = timer.it_interval;
+
+    timerfd_settime(counter_fd, 0, &timer, nullptr);
+    syscalls.fetch_add(1, std::memory_order_relaxed);
+    polling = interval.count() > 0;
+}
+
+bool Reactor::catch_up_ports()
+{
+    // Ports that went away still hand over what they held back.
+    auto       fed  = false;
+    const auto feed = [&fed](Serial &serial) {
+        if (!serial.behind.load(std::memory_order_relaxed)) { return false; }
+        const auto before    = serial.stored;
+        const auto caught_up = !serial.has_backlog() || serial.catch_up();
+        fed                  = fed || serial.stored != before;
+        return caught_up;
+    };
+
+    for (const auto &[id, serial] : ports) {
+        const auto caught_up = feed(*serial);
+        if (serial->paused && !serial->must_pause()) {
+            resume_port(id, *serial);
+        }
+        if (caught_up && !serial->paused) {
+            serial->behind.store(false, std::memory_order_relaxed);
+        }
+    }
+    for (const auto &[_, serial] : retrying) {
+        if (feed(*serial)) {
+            serial->behind.store(false, std::memory_order_relaxed);
+        }
+    }
+    return fed;
+}
+
+void Reactor::throttle(const std::uint64_t id, Serial &serial)
+{
+    if (!serial.paused && serial.must_pause()) { pause_port(id, serial); }
+}
+
+void Reactor::pause_port(const std::uint64_t id, Serial &serial)
+{
+    // Out of epoll altogether, a hangup would otherwise keep reporting the
+    // fd while nothing reads it.
+    if (uring) {
+        auto *sqe      = next_sqe();
+        sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+        sqe->addr      = id;
+        sqe->user_data = CANCEL_ID;
+    } else {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, serial.fd, nullptr);
+    }
+    syscalls.fetch_add(1, std::memory_order_relaxed);
+
+    serial.paused = true;
+    serial.behind.store(true, std::memory_order_relaxed);
+    serial.pauses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Reactor::resume_port(const std::uint64_t id, Serial &serial)
+{
+    serial.paused = false;
+    if (uring) {
+        arm_read(id, serial.fd);
+        return;
+    }
+
+    epoll_event event{};
+    event.events   = EPOLLIN;
+    event.data.u64 = id;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, serial.fd, &event) < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to resume reading serial port: {}\n",
+          strerror(errno)
+        );
+        drop_port(id);
+        return;
+    }
+    syscalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Reactor::signal_activity()
+{
+    if (!on_activity) { return; }
+    if (activity_pending.exchange(true, std::memory_order_relaxed)) { return; }
+    on_activity();
+}
+
+void Reactor::run_epoll()
+{
+    constexpr std::size_t MAX_EVENTS = 64;
+
+    std::array<epoll_event, MAX_EVENTS> events{};
+    // Where reads go once a port's ring is full, shared by every port.
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+    std::array<char, Serial::READ_CHUNK_SIZE> overflow;
+
+    SESAMO_TRACE_THREAD("reactor");
+    while (!stop.load(std::memory_order_relaxed)) {
+        const auto ready = epoll_wait(
+          epoll_fd, events.data(), static_cast<int>(events.size()), -1
+        );
+        syscalls.fetch_add(1, std::memory_order_relaxed);
+        wakeups.fetch_add(1, std::memory_order_relaxed);
+        if (ready < 0) {
+            if (errno == EINTR) { continue; }
+            std::print(
+              stderr,
+              "[ERROR] failed to wait for serial port events: {}\n",
+              strerror(errno)
+            );
+            break;
+        }
+
+        SESAMO_TRACE_SCOPE("reactor.dispatch");
+        auto active = false;
+        for (const auto &event :
+             std::span(events.data(), static_cast<std::size_t>(ready))) {
+            if (event.data.u64 == WAKEUP_ID) {
+                apply_commands();
+                active = catch_up_ports() || active;
+                continue;
+            }
+            if (event.data.u64 == RETRY_ID) {
+                retry_ports();
+                continue;
+            }
+            if (event.data.u64 == COUNTERS_ID) {
+                active = poll_counters() || active;
+                continue;
+            }
+
+            const auto port = ports.find(event.data.u64);
+            if (port == ports.end()) { continue; }
+            if (!port->second->drain(overflow)) {
+                drop_port(port->first);
+            } else {
+                throttle(port->first, *port->second);
+            }
+            active = true;
+        }
+
+        if (active) { signal_activity(); }
+    }
+
+    shutdown();
+}
+
+void Reactor::run_io_uring()
+{
+    std::vector<std::uint64_t> rearm;
+    std::vector<std::uint64_t> failed;
+
+    arm_poll(wakeup_fd, WAKEUP_ID);
+    arm_poll(retry_fd, RETRY_ID);
+    arm_poll(counter_fd, COUNTERS_ID);
+
+    SESAMO_TRACE_THREAD("reactor");
+    while (!stop.load(std::memory_order_relaxed)) {
+        const auto result = uring->submit_and_wait(1);
+        syscalls.fetch_add(1, std::memory_order_relaxed);
+        wakeups.fetch_add(1, std::memory_order_relaxed);
+        if (result < 0 && result != -EINTR) {
+            std::print(
+              stderr,
+              "[ERROR] failed to wait for io_uring completions: {}\n",
+              strerror(-result)
+            );
+            break;
+        }
+
+        SESAMO_TRACE_SCOPE("reactor.dispatch");
+        auto woken  = false;
+        auto due    = false;
+        auto tick   = false;
+        auto active = false;
+        uring->for_each_cqe([&](const io_uring_cqe &cqe) {
+            if (cqe.user_data == WAKEUP_ID) {
+                woken = true;
+                return;
+            }
+            if (cqe.user_data == RETRY_ID) {
+                due = true;
+                return;
+            }
+            if (cqe.user_data == COUNTERS_ID) {
+                tick = true;
+                return;
+            }
+            if (cqe.user_data == CANCEL_ID) { return; }
+
+            const auto port = ports.find(cqe.user_data);
+
+            // Buffers go back to the kernel even when the port is gone.
+            if ((cqe.flags & IORING_CQE_F_BUFFER) != 0) {
+                const auto id = static_cast<std::uint16_t>(
+                  cqe.flags >> IORING_CQE_BUFFER_SHIFT
+                );
+                if (port != ports.end() && cqe.res > 0) {
+                    port->second->store(
+                      uring->buffer(id, static_cast<std::size_t>(cqe.res))
+                    );
+                    throttle(port->first, *port->second);
+                }
+                uring->recycle_buffer(id);
+            }
+
+            // A port that was paused, it is re-armed once resumed.
+            if (port == ports.end() || cqe.res == -ECANCELED) { return; }
+            active = true;
+
+            if (cqe.res == 0) {
+                std::print(stderr, "[ERROR] serial port hung up\n");
+                failed.push_back(cqe.user_data);
+            } else if (cqe.res < 0 && cqe.res != -ENOBUFS) {
+                std::print(
+                  stderr,
+                  "[ERROR] failed to read from serial port: {}\n",
+                  strerror(-cqe.res)
+                );
+                failed.push_back(cqe.user_data);
+            } else if ((cqe.flags & IORING_CQE_F_MORE) == 0) {
+                // The kernel ends a multishot read when it ran out of
+                // provided buffers, they were recycled above so re-arm.
+                rearm.push_back(cqe.user_data);
+            }
+        });
+
+        for (const auto id : failed) { drop_port(id); }
+        failed.clear();
+
+        for (const auto id : rearm) {
+            const auto port = ports.find(id);
+            if (port != ports.end() && !port->second->paused) {
+                arm_read(id, port->second->fd);
+            }
+        }
+        rearm.clear();
+
+        if (tick) {
+            active = poll_counters() || active;
+            arm_poll(counter_fd, COUNTERS_ID);
+        }
+
+        if (active) { signal_activity(); }
+
+        if (due) {
+            retry_ports();
+            arm_poll(retry_fd, RETRY_ID);
+        }
+
+        if (woken) {
+            apply_commands();
+            if (catch_up_ports()) { signal_activity(); }
+            arm_poll(wakeup_fd, WAKEUP_ID);
+        }
+    }
+
+    shutdown();
+}
+
+io_uring_sqe *Reactor::next_sqe()
+{
+    auto *sqe = uring->get_sqe();
+    while (sqe == nullptr) {
+        // Flush what is queued to make room, completions stay in the
+        // completion queue until the next loop iteration picks them up.
+        [[maybe_unused]] const auto _ = uring->submit_and_wait(0);
+        syscalls.fetch_add(1, std::memory_order_relaxed);
+        sqe = uring->get_sqe();
+    }
+    return sqe;
+}
+
+void Reactor::arm_read(const std::uint64_t id, const int fd)
+{
+    auto *sqe      = next_sqe();
+    sqe->opcode    = IoUring::OP_READ_MULTISHOT;
+    sqe->fd        = fd;
+    sqe->flags     = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = IoUring::BUFFER_GROUP;
+    sqe->user_data = id;
+}
+
+void Reactor::arm_poll(const int fd, const std::uint64_t id)
+{
+    auto *sqe          = next_sqe();
+    sqe->opcode        = IORING_OP_POLL_ADD;
+    sqe->fd            = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data     = id;
+}
@@ -0,0 +1,228 @@
+#ifndef SESAMO_REACTOR_HPP
+#define SESAMO_REACTOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "IoUring.hpp"
+
+class Serial;
+
+// A single thread multiplexing the reads of every attached serial port,
+// either through epoll or through io_uring multishot reads.
+//
+// Ports are attached and detached from any thread, the calls are handed to
+// the reactor thread and block until it has applied them, so once detach()
+// returns the reactor will not touch the port (or its fd) again.
+//
+// A port that fails while set to reconnect stays attached: the reactor
+// closes its fd and reopens it from a timer with backoff, the consumer
+// keeps reading the same Serial throughout.
+class [[nodiscard]] Reactor final
+{
+  public:
+    enum class Backend : std::uint8_t
+    {
+        Epoll,
+        IoUring,
+    };
+
+    struct Stats
+    {
+        std::uint64_t wakeups  = 0;
+        std::uint64_t syscalls = 0;
+    };
+
+    // How the reactor thread should be scheduled, see tune().
+    struct Tuning
+    {
+        // Core the thread is pinned to.
+        std::optional<unsigned> cpu;
+        // SCHED_FIFO priority, 1 to 99.
+        std::optional<int> priority;
+        // mlock() the read buffers of the reactor and of every port attached
+        // now or later, so a read never stalls on a page fault.
+        bool lock_memory = false;
+
+        [[nodiscard]] bool requested() const noexcept
+        {
+            return cpu || priority || lock_memory;
+        }
+    };
+
+    // What tune() actually got, a setting the kernel refused stays false.
+    struct Tuned
+    {
+        bool        pinned       = false;
+        bool        realtime     = false;
+        bool        locked       = false;
+        std::size_t locked_bytes = 0;
+    };
+
+    // `Backend::IoUring` falls back to epoll when the running kernel lacks
+    // io_uring or multishot reads. Returns nullptr if no backend could be
+    // set up at all.
+    //
+    // `on_activity` is called on the reactor thread when a port received
+    // data, went away or came back, at most once until
+    // acknowledge_activity().
+    [[nodiscard]] static auto spawn(
+      const Backend         backend,
+      std::function<void()> on_activity = {}
+    ) -> std::shared_ptr<Reactor>;
+
+    ~Reactor();
+
+    Reactor(const Reactor &)            = delete;
+    Reactor &operator=(const Reactor &) = delete;
+    Reactor(Reactor &&)                 = delete;
+    Reactor &operator=(Reactor &&)      = delete;
+
+    [[nodiscard]] bool attach(const std::shared_ptr<Serial> &serial);
+    void               detach(const Serial &serial);
+
+    // Runs `task` on the reactor thread between two rounds of reads and
+    // waits for it, false if the reactor already stopped.
+    [[nodiscard]] bool execute(std::function<void()> task);
+
+    [[nodiscard]] Backend backend() const noexcept
+    {
+        return uring ? Backend::IoUring : Backend::Epoll;
+    }
+
+    [[nodiscard]] Stats stats() const noexcept
+    {
+        return { .wakeups  = wakeups.load(std::memory_order_relaxed),
+                 .syscalls = syscalls.load(std::memory_order_relaxed) };
+    }
+
+    // Tells the reactor a consumer made room in a port that stopped reading
+    // or has bytes waiting for it (see Serial::Backpressure), without
+    // waiting for it to catch up.
+    void resume_reading() const { wake(); }
+
+    // Lets the next port activity call `on_activity` again, consumers call
+    // this right before they look at the ports.
+    void acknowledge_activity() noexcept
+    {
+        activity_pending.store(false, std::memory_order_relaxed);
+    }
+
+    // Applies `tuning` to the reactor thread and reports what took effect.
+    // Settings that need privileges (CAP_SYS_NICE for SCHED_FIFO, enough
+    // RLIMIT_MEMLOCK) are skipped with a warning when not permitted.
+    [[nodiscard]] Tuned tune(const Tuning &tuning);
+
+    // One line on what of `tuning` was applied, e.g. "cpu 2, SCHED_FIFO 50,
+    // buffers locked".
+    [[nodiscard]] static std::string
+      describe(const Tuning &tuning, const Tuned &tuned);
+
+    // CPU time consumed by the reactor thread so far.
+    [[nodiscard]] std::chrono::nanoseconds cpu_time() const;
+
+  private:
+    Reactor(
+      int                      epoll_fd,
+      int                      wakeup_fd,
+      int                      retry_fd,
+      int                      counter_fd,
+      std::unique_ptr<IoUring> uring,
+      std::function<void()>    on_activity
+    );
+
+    struct Command
+    {
+        std::shared_ptr<Serial> attach;
+        const Serial           *detach = nullptr;
+        std::function<void()>   task;
+        std::promise<bool>      done;
+    };
+
+    // The io_uring backend keeps one multishot read armed per port, all of
+    // them picking from this many shared buffers of IO_URING_BUFFER_SIZE.
+    constexpr static unsigned      IO_URING_QUEUE_DEPTH  = 256;
+    constexpr static std::uint16_t IO_URING_BUFFER_COUNT = 64;
+    constexpr static std::uint32_t IO_URING_BUFFER_SIZE  = 16 * 1024;
+
+    // Reserved io_uring user_data values, ports are numbered from 1.
+    constexpr static std::uint64_t WAKEUP_ID   = 0;
+    constexpr static std::uint64_t COUNTERS_ID = UINT64_MAX - 2;
+    constexpr static std::uint64_t RETRY_ID    = UINT64_MAX - 1;
+    constexpr static std::uint64_t CANCEL_ID   = UINT64_MAX;
+
+    int                      epoll_fd   = -1;
+    int                      wakeup_fd  = -1;
+    // timerfd expiring when the next reconnect attempt is due.
+    int                      retry_fd   = -1;
+    // timerfd ticking every Serial::COUNTER_INTERVAL while an attached port
+    // has line counters.
+    int                      counter_fd = -1;
+    std::unique_ptr<IoUring> uring;
+    std::thread              thread;
+    clockid_t                cpu_clock{};
+    std::atomic<bool>        stop;
+
+    std::mutex           commands_mutex;
+    std::vector<Command> commands;
+    bool                 running; // guarded by commands_mutex
+
+    // Only ever touched by the reactor thread.
+    std::unordered_map<std::uint64_t, std::shared_ptr<Serial>> ports;
+    std::uint64_t                                             next_id = 1;
+    // Ports that went away and are waiting to be reopened, under the id
+    // they had.
+    std::unordered_map<std::uint64_t, std::shared_ptr<Serial>> retrying;
+    // Whether attached ports get their buffers locked, and how many bytes
+    // were locked so far.
+    bool        lock_memory  = false;
+    std::size_t locked_bytes = 0;
+    // Whether `counter_fd` is armed.
+    bool polling = false;
+
+    std::function<void()> on_activity;
+    std::atomic<bool>     activity_pending;
+
+    std::atomic<std::uint64_t> wakeups;
+    std::atomic<std::uint64_t> syscalls;
+
+    void               wake() const;
+    [[nodiscard]] bool post(Command command);
+    void               apply_commands();
+    void               shutdown();
+    [[nodiscard]] bool add_port(const std::shared_ptr<Serial> &serial);
+    void               remove_port(const Serial &serial);
+    void               drop_port(std::uint64_t id);
+    void               retry_ports();
+    void               schedule_retries();
+    [[nodiscard]] bool poll_counters();
+    void               poll_every(std::chrono::milliseconds interval);
+    [[nodiscard]] bool catch_up_ports();
+    void               throttle(std::uint64_t id, Serial &serial);
+    void               pause_port(std::uint64_t id, Serial &serial);
+    void               resume_port(std::uint64_t id, Serial &serial);
+    void               signal_activity();
+    [[nodiscard]] bool lock_port(Serial &serial);
+    [[nodiscard]] bool lock_stack();
+
+    void run_epoll();
+    void run_io_uring();
+    // A submission entry to fill in, never nullptr: a full queue is
+    // submitted first to make room.
+    [[nodiscard]] io_uring_sqe *next_sqe();
+    void                        arm_read(std::uint64_t id, int fd);
+    void                        arm_poll(int fd, std::uint64_t id);
+};
+
+#endif // SESAMO_REACTOR_HPP
@@ -0,0 +1,310 @@
+#include "Replay.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <print>
+
+namespace
+{
+
+// Never start a sleep earlier than this, whatever the observed latency.
+constexpr std::int64_t MAX_WAKEUP_LEAD = 1'000'000;
+
+// How long a finished replay waits for consumers to read the rest.
+constexpr std::int64_t DRAIN_TIMEOUT       = 2'000'000'000;
+constexpr std::int64_t DRAIN_POLL_INTERVAL = 1'000'000;
+
+// How long a pty may take nothing before it is given up on, say one nobody
+// opened with --no-wait.
+constexpr int STALL_TIMEOUT_MS = 2000;
+
+[[nodiscard]] std::int64_t monotonic_now()
+{
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * 1'000'000'000) + now.tv_nsec;
+}
+
+void sleep_until(const std::int64_t deadline)
+{
+    const timespec until{ .tv_sec  = deadline / 1'000'000'000,
+                          .tv_nsec = deadline % 1'000'000'000 };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr)
+           == EINTR) {}
+}
+
+// Writes all of `bytes` to the non-blocking `fd`, waiting for room while
+// it is full. False on an error, errno is ETIMEDOUT if the reader stalled.
+[[nodiscard]] bool write_all(const int fd, std::span<const char> bytes)
+{
+    while (!bytes.empty()) {
+        const auto written = ::write(fd, bytes.data(), bytes.size());
+        if (written < 0) {
+            if (errno == EINTR) { continue; }
+            if (errno != EAGAIN) { return false; }
+
+            pollfd writable{ .fd = fd, .events = POLLOUT, .revents = 0 };
+            const auto ready = poll(&writable, 1, STALL_TIMEOUT_MS);
+            if (ready == 0) { errno = ETIMEDOUT; }
+            if (ready <= 0 && errno != EINTR) { return false; }
+            continue;
+        }
+        bytes = bytes.subspan(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+// The requested percentile (0-100) of `samples`, reorders them.
+[[nodiscard]] std::chrono::nanoseconds
+  percentile(std::vector<std::int64_t> &samples, const double which)
+{
+    if (samples.empty()) { return {}; }
+
+    const auto rank = static_cast<std::size_t>(
+      (which / 100.0) * static_cast<double>(samples.size() - 1)
+    );
+    std::ranges::nth_element(
+      samples, samples.begin() + static_cast<std::ptrdiff_t>(rank)
+    );
+    return std::chrono::nanoseconds(samples[rank]);
+}
+
+} // namespace
+
+auto Replay::create(std::unique_ptr<CaptureReader> reader)
+  -> std::unique_ptr<Replay>
+{
+    if (reader->ports().empty()) {
+        std::print(stderr, "[ERROR] the capture does not name any port\n");
+        return nullptr;
+    }
+
+    auto replay = std::unique_ptr<Replay>(new Replay(std::move(reader)));
+    if (!replay->open_ptys()) { return nullptr; }
+    return replay;
+}
+
+Replay::Replay(std::unique_ptr<CaptureReader> reader)
+  : reader(std::move(reader))
+{}
+
+Replay::~Replay()
+{
+    for (const auto &pty : terminals) {
+        if (pty.slave >= 0) { ::close(pty.slave); }
+        if (pty.master >= 0) { ::close(pty.master); }
+    }
+}
+
+bool Replay::open_ptys()
+{
+    for (const auto port : reader->ports()) {
+        auto &pty = terminals.emplace_back();
+        pty.port  = port;
+        pty.name  = reader->port_name(port);
+
+        pty.master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+        std::array<char, 64> path{};
+        if (pty.master < 0 || grantpt(pty.master) < 0
+            || unlockpt(pty.master) < 0
+            || ptsname_r(pty.master, path.data(), path.size()) != 0) {
+            std::print(
+              stderr, "[ERROR] failed to create a pty: {}\n", strerror(errno)
+            );
+            return false;
+        }
+        pty.path = path.data();
+        // Writes must not block for good on a pty nobody reads.
+        // NOLINTNEXTLINE
+        fcntl(pty.master, F_SETFL, O_NONBLOCK);
+
+        // NOLINTNEXTLINE
+        pty.slave = ::open(path.data(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+        termios tty{};
+        if (pty.slave < 0 || tcgetattr(pty.slave, &tty) != 0) {
+            std::print(
+              stderr,
+              "[ERROR] failed to open {}: {}\n",
+              pty.path,
+              strerror(errno)
+            );
+            return false;
+        }
+
+        // Bytes go through exactly as captured until the consumer sets the
+        // port up the way it likes.
+        cfmakeraw(&tty);
+        tcsetattr(pty.slave, TCSANOW, &tty);
+    }
+
+    return true;
+}
+
+const Replay::Pty *Replay::pty_of(const std::uint16_t port) const
+{
+    const auto match = std::ranges::find(terminals, port, &Pty::port);
+    return match == terminals.end() ? nullptr : &*match;
+}
+
+void Replay::wait_until_read() const
+{
+    // Closing the master hangs the slave up, which throws away whatever the
+    // consumer did not read yet.
+    const auto deadline = monotonic_now() + DRAIN_TIMEOUT;
+    for (const auto &pty : terminals) {
+        auto pending = 0;
+        while (ioctl(pty.slave, FIONREAD, &pending) == 0 && pending > 0
+               && monotonic_now() < deadline) {
+            sleep_until(monotonic_now() + DRAIN_POLL_INTERVAL);
+        }
+    }
+}
+
+bool Replay::wait_for_consumers() const
+{
+    const auto fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0) {
+        std::print(
+          stderr, "[ERROR] failed to create inotify: {}\n", strerror(errno)
+        );
+        return false;
+    }
+
+    std::vector<int> watches;
+    for (const auto &pty : terminals) {
+        watches.push_back(inotify_add_watch(fd, pty.path.c_str(), IN_OPEN));
+    }
+
+    auto waiting = watches.size();
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+    alignas(inotify_event) std::array<char, 4096> events;
+    while (waiting > 0) {
+        const auto bytes = ::read(fd, events.data(), events.size());
+        if (bytes < 0) {
+            if (errno == EINTR) { continue; }
+            std::print(
+              stderr,
+              "[ERROR] failed to wait for consumers: {}\n",
+              strerror(errno)
+            );
+            ::close(fd);
+            return false;
+        }
+
+        for (std::size_t offset = 0;
+             offset < static_cast<std::size_t>(bytes);) {
+            inotify_event event{};
+            std::memcpy(&event, events.data() + offset, sizeof(event));
+            offset += sizeof(event) + event.len;
+
+            const auto watch = std::ranges::find(watches, event.wd);
+            if (watch == watches.end()) { continue; }
+            *watch = -1;
+            --waiting;
+        }
+    }
+
+    ::close(fd);
+    return true;
+}
+
+auto Replay::run(const Options &options) -> std::optional<Report>
+{
+    Report report;
+
+    reader->rewind();
+    const auto first = reader->next();
+    if (!first) { return report; }
+
+    reader->rewind();
+    if (options.from.count() > 0
+        && !reader->seek_time(first->monotonic + options.from.count())) {
+        return report;
+    }
+
+    // The default 50us timer slack would dominate the error at high rates.
+    prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+
+    std::vector<std::int64_t>   errors;
+    std::int64_t                latency = 0;
+    std::optional<std::int64_t> base;
+    std::vector<const Pty *>    stalled;
+
+    const auto start = monotonic_now();
+    while (const auto chunk = reader->next()) {
+        const auto *pty = chunk->direction == capture::Direction::Receive
+                            ? pty_of(chunk->port)
+                            : nullptr;
+        if (pty == nullptr
+            || std::ranges::find(stalled, pty) != stalled.end()) {
+            ++report.skipped;
+            continue;
+        }
+        if (!base) { base = chunk->monotonic; }
+
+        auto deadline = start;
+        if (options.speed > 0) {
+            deadline += static_cast<std::int64_t>(
+              static_cast<double>(chunk->monotonic - *base) / options.speed
+            );
+
+            // Aim early by the latency wakeups had so far, then learn from
+            // how late this one came back.
+            const auto wake = deadline - latency;
+            if (wake > monotonic_now()) {
+                sleep_until(wake);
+                const auto late = monotonic_now() - wake;
+                latency         = std::clamp<std::int64_t>(
+                  latency + ((late - latency) / 8), 0, MAX_WAKEUP_LEAD
+                );
+            }
+        }
+
+        const auto sent = monotonic_now();
+        if (!write_all(pty->master, chunk->bytes)) {
+            if (errno == ETIMEDOUT) {
+                std::print(
+                  stderr,
+                  "[WARNING] nothing read from {} for {} ms, skipping the "
+                  "rest of its chunks\n",
+                  pty->path,
+                  STALL_TIMEOUT_MS
+                );
+                stalled.push_back(pty);
+                ++report.skipped;
+                continue;
+            }
+            std::print(
+              stderr,
+              "[ERROR] failed to replay into {}: {}\n",
+              pty->path,
+              strerror(errno)
+            );
+            return std::nullopt;
+        }
+
+        if (options.speed > 0) { errors.push_back(sent - deadline); }
+        ++report.chunks;
+        report.bytes     += chunk->bytes.size();
+        report.scheduled  = std::chrono::nanoseconds(deadline - start);
+    }
+    report.elapsed = std::chrono::nanoseconds(monotonic_now() - start);
+
+    wait_until_read();
+
+    report.error_p50  = percentile(errors, 50);
+    report.error_p99  = percentile(errors, 99);
+    report.error_p999 = percentile(errors, 99.9);
+    report.error_max  = percentile(errors, 100);
+    return report;
+}
@@ -0,0 +1,101 @@
+#ifndef SESAMO_REPLAY_HPP
+#define SESAMO_REPLAY_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "CaptureReader.hpp"
+
+// Plays a capture back into pseudo terminals, one per captured port, so any
+// consumer of the slave side (sesamo's own Serial::open included) sees the
+// recorded bytes again, either at the recorded pace, sped up or as fast as
+// the ptys take them.
+//
+// Every chunk is due at an absolute CLOCK_MONOTONIC deadline derived from
+// its capture time, so a late wakeup never pushes the following ones back.
+// The sleep itself is clock_nanosleep(TIMER_ABSTIME), started early by the
+// wakeup latency observed so far, which keeps the systematic part of the
+// error out of the schedule.
+class [[nodiscard]] Replay final
+{
+  public:
+    struct Pty
+    {
+        std::uint16_t port = 0;
+        std::string   name;
+        std::string   path;
+        int           master = -1;
+        // Kept open so the pty stays configured and buffers what is
+        // written before the consumer opens it.
+        int slave = -1;
+    };
+
+    struct Options
+    {
+        // Multiple of the recorded pace, 0 replays as fast as possible.
+        double                   speed = 1.0;
+        // Skip the beginning of the capture, found through its index.
+        std::chrono::nanoseconds from{ 0 };
+    };
+
+    struct Report
+    {
+        std::uint64_t            chunks  = 0;
+        std::uint64_t            bytes   = 0;
+        // Chunks of ports without a pty (unnamed or transmitted ones) or
+        // whose pty stopped being read.
+        std::uint64_t            skipped = 0;
+        std::chrono::nanoseconds elapsed{ 0 };
+        // How long the replayed part took when it was recorded, divided by
+        // the speed.
+        std::chrono::nanoseconds scheduled{ 0 };
+        // How late chunks went out compared to their deadline.
+        std::chrono::nanoseconds error_p50{ 0 };
+        std::chrono::nanoseconds error_p99{ 0 };
+        std::chrono::nanoseconds error_p999{ 0 };
+        std::chrono::nanoseconds error_max{ 0 };
+    };
+
+    // Creates one raw pty per port in `reader`. Returns nullptr if the
+    // capture names no port or a pty could not be set up.
+    [[nodiscard]] static auto create(std::unique_ptr<CaptureReader> reader)
+      -> std::unique_ptr<Replay>;
+
+    ~Replay();
+
+    Replay(const Replay &)            = delete;
+    Replay &operator=(const Replay &) = delete;
+    Replay(Replay &&)                 = delete;
+    Replay &operator=(Replay &&)      = delete;
+
+    [[nodiscard]] const std::vector<Pty> &ptys() const noexcept
+    {
+        return terminals;
+    }
+
+    // Blocks until every pty's slave side has been opened by someone else.
+    [[nodiscard]] bool wait_for_consumers() const;
+
+    // Plays the capture once, blocking the calling thread. Writes wait
+    // while a consumer lags behind, which shows up as timing error, a pty
+    // that takes nothing for a couple of seconds is skipped from then on.
+    // Returns once the consumers read everything or stopped reading for a
+    // while.
+    [[nodiscard]] std::optional<Report> run(const Options &options);
+
+  private:
+    explicit Replay(std::unique_ptr<CaptureReader> reader);
+
+    std::unique_ptr<CaptureReader> reader;
+    std::vector<Pty>               terminals;
+
+    [[nodiscard]] bool open_ptys();
+    void               wait_until_read() const;
+    [[nodiscard]] const Pty *pty_of(std::uint16_t port) const;
+};
+
+#endif // SESAMO_REPLAY_HPP
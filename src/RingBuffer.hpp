@@ -0,0 +1,259 @@
+#ifndef SESAMO_RING_BUFFER_HPP
+#define SESAMO_RING_BUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+// Fixed capacity single-producer/single-consumer byte ring.
+//
+// The producer asks for a contiguous writable span, fills it (e.g. straight
+// from ::read) and commits what it wrote. The consumer gets a contiguous
+// readable span and consumes it once done. Neither side ever blocks or
+// allocates, and the two indices live on separate cache lines so the reader
+// thread and the UI thread do not false share.
+//
+// A producer that would rather lose the oldest bytes than the newest may
+// discard() what the consumer did not get to yet, as long as the consumer
+// only ever reads through read_all(). read_all() marks the tail while it
+// hands out bytes and discard() gives up nothing while it is marked, so
+// neither side ever waits for the other and what the consumer looks at is
+// never written over.
+class [[nodiscard]] RingBuffer final
+{
+  public:
+    explicit RingBuffer(const std::size_t capacity)
+      : mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+        data(std::make_unique_for_overwrite<char[]>(mask + 1))
+    {}
+
+    RingBuffer(const RingBuffer &)            = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+    RingBuffer(RingBuffer &&)                 = delete;
+    RingBuffer &operator=(RingBuffer &&)      = delete;
+
+    ~RingBuffer() = default;
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return mask + 1; }
+
+    // The memory behind the ring, e.g. to mlock() it.
+    [[nodiscard]] std::span<const char> storage() const noexcept
+    {
+        return { data.get(), capacity() };
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        // Tail first, a discard() in between must not pass the head we read.
+        const auto current = released();
+        return head.load(std::memory_order_acquire) - current;
+    }
+
+    // Producer side.
+    [[nodiscard]] std::span<char> write_span() noexcept
+    {
+        const auto current = head.load(std::memory_order_relaxed);
+        const auto offset  = current & mask;
+        const auto free =
+          capacity() - (current - released());
+        return { data.get() + offset, std::min(free, capacity() - offset) };
+    }
+
+    // Copies all of `bytes` in, wrapping around the end if needed, or
+    // nothing at all when they do not fit.
+    [[nodiscard]] bool write(const std::span<const char> bytes) noexcept
+    {
+        return write(bytes, {});
+    }
+
+    // Same for two pieces that have to land back to back, say a header and
+    // its payload: the consumer sees both or neither.
+    [[nodiscard]] bool write(
+      const std::span<const char> first,
+      const std::span<const char> second
+    ) noexcept
+    {
+        const auto current = head.load(std::memory_order_relaxed);
+        const auto free =
+          capacity() - (current - released());
+        if (free < first.size() + second.size()) { return false; }
+
+        copy_to(current, first);
+        copy_to(current + first.size(), second);
+        commit(first.size() + second.size());
+        return true;
+    }
+
+    void commit(const std::size_t bytes) noexcept
+    {
+        head.store(
+          head.load(std::memory_order_relaxed) + bytes,
+          std::memory_order_release
+        );
+    }
+
+    // Gives up to `bytes` of the oldest readable bytes to make room, none
+    // while the consumer is inside read_all() since it may be looking at
+    // exactly those. Returns how many bytes went.
+    [[nodiscard]] std::size_t discard(const std::size_t bytes) noexcept
+    {
+        const auto  current = head.load(std::memory_order_relaxed);
+        auto        from    = tail.load(std::memory_order_acquire);
+        std::size_t count   = 0;
+        do {
+            if ((from & READING) != 0) { return 0; }
+            count = std::min(bytes, current - from);
+        } while (count > 0
+                 && !tail.compare_exchange_weak(
+                   from,
+                   from + count,
+                   std::memory_order_acq_rel,
+                   std::memory_order_acquire
+                 ));
+        return count;
+    }
+
+    // Consumer side.
+    [[nodiscard]] std::span<const char> read_span() noexcept
+    {
+        const auto current = tail.load(std::memory_order_relaxed);
+        const auto offset  = current & mask;
+        const auto available =
+          head.load(std::memory_order_acquire) - current;
+        return { data.get() + offset,
+                 std::min(available, capacity() - offset) };
+    }
+
+    // Fills all of `bytes`, wrapping around the end if needed, or nothing at
+    // all when fewer are available.
+    [[nodiscard]] bool read(const std::span<char> bytes) noexcept
+    {
+        const auto current = tail.load(std::memory_order_relaxed);
+        const auto available =
+          head.load(std::memory_order_acquire) - current;
+        if (available < bytes.size()) { return false; }
+
+        const auto offset = current & mask;
+        const auto first  = std::min(bytes.size(), capacity() - offset);
+        std::copy_n(data.get() + offset, first, bytes.data());
+        std::copy_n(data.get(), bytes.size() - first, bytes.data() + first);
+        consume(bytes.size());
+        return true;
+    }
+
+    void consume(const std::size_t bytes) noexcept
+    {
+        tail.store(
+          tail.load(std::memory_order_relaxed) + bytes,
+          std::memory_order_release
+        );
+    }
+
+    // Hands everything readable to `consumer` as (at most two) contiguous
+    // `std::span<const char>` views and consumes them once it returns.
+    // Returns the bytes consumed.
+    template <typename Consumer>
+    std::size_t read_all(Consumer &&consumer)
+    {
+        return read_all(std::forward<Consumer>(consumer), [](std::size_t) {});
+    }
+
+    // Same, but first tells `on_discarded` how many bytes the producer
+    // discarded since the last call, if it did.
+    template <typename Consumer, typename OnDiscarded>
+    std::size_t read_all(Consumer &&consumer, OnDiscarded &&on_discarded)
+    {
+        // Only a discard() can get in between, and it never waits for us.
+        auto current = tail.load(std::memory_order_acquire);
+        while (!tail.compare_exchange_weak(
+          current,
+          current | READING,
+          std::memory_order_acq_rel,
+          std::memory_order_acquire
+        )) {}
+        if (current != delivered) { on_discarded(current - delivered); }
+
+        const auto end    = head.load(std::memory_order_acquire);
+        const auto offset = current & mask;
+        const auto first  = std::min(end - current, capacity() - offset);
+        if (first > 0) {
+            consumer(std::span<const char>(data.get() + offset, first));
+        }
+        if (end - current > first) {
+            consumer(std::span<const char>(data.get(), end - current - first));
+        }
+        delivered = end;
+
+        // Consumes them and lets discard() back in.
+        tail.store(end, std::memory_order_release);
+        return end - current;
+    }
+
+    // Fixed size records on top of write()/read(), for queues of small
+    // trivially copyable structs rather than a byte stream.
+    template <typename Record>
+        requires std::is_trivially_copyable_v<Record>
+    [[nodiscard]] bool write_record(const Record &record) noexcept
+    {
+        // NOLINTNEXTLINE
+        const auto *bytes = reinterpret_cast<const char *>(&record);
+        return write({ bytes, sizeof(Record) });
+    }
+
+    // Hands every complete record queued so far to `consumer`, returns how
+    // many there were.
+    template <typename Record, typename Consumer>
+        requires std::is_trivially_copyable_v<Record>
+    std::size_t read_records(Consumer &&consumer)
+    {
+        std::size_t total = 0;
+        Record      record{};
+        // NOLINTNEXTLINE
+        while (read({ reinterpret_cast<char *>(&record), sizeof(Record) })) {
+            consumer(record);
+            ++total;
+        }
+        return total;
+    }
+
+  private:
+    constexpr static std::size_t CACHE_LINE_SIZE = 64;
+
+    // Set in the tail while read_all() hands out bytes, positions never get
+    // anywhere near it.
+    constexpr static std::size_t READING = std::size_t{ 1 }
+                                           << (sizeof(std::size_t) * 8 - 1);
+
+    // The tail without the READING mark, as seen from the producer side.
+    [[nodiscard]] std::size_t released() const noexcept
+    {
+        return tail.load(std::memory_order_acquire) & ~READING;
+    }
+
+    void copy_to(const std::size_t position, const std::span<const char> bytes)
+      noexcept
+    {
+        const auto offset = position & mask;
+        const auto first  = std::min(bytes.size(), capacity() - offset);
+        std::copy_n(bytes.data(), first, data.get() + offset);
+        std::copy_n(bytes.data() + first, bytes.size() - first, data.get());
+    }
+
+    const std::size_t             mask;
+    const std::unique_ptr<char[]> data;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail = 0;
+    // Consumer side of discard(): where read_all() left off.
+    std::size_t delivered = 0;
+    // Keep whatever follows us in memory off the tail's cache line.
+    [[maybe_unused]] char
+      padding[CACHE_LINE_SIZE - sizeof(tail) - sizeof(delivered)]{};
+};
+
+#endif // SESAMO_RING_BUFFER_HPP
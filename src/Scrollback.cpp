@@ -0,0 +1,152 @@
+#include "Scrollback.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <print>
+#include <sys/mman.h>
+#include <unistd.h>
+
+auto Scrollback::create(const std::size_t capacity)
+  -> std::unique_ptr<Scrollback>
+{
+    const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const auto size = std::max((capacity + page - 1) / page * page, page);
+
+    const auto fd = memfd_create("sesamo-scrollback", MFD_CLOEXEC);
+    if (fd < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to create scrollback memory: {}\n",
+          strerror(errno)
+        );
+        return nullptr;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to size scrollback memory: {}\n",
+          strerror(errno)
+        );
+        ::close(fd);
+        return nullptr;
+    }
+
+    // Reserve twice the size, then map the same pages over both halves.
+    auto *reserved =
+      mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        std::print(
+          stderr,
+          "[ERROR] failed to reserve scrollback memory: {}\n",
+          strerror(errno)
+        );
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto *data = static_cast<char *>(reserved);
+    for (auto *half : { data, data + size }) {
+        if (mmap(
+              half,
+              size,
+              PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_FIXED,
+              fd,
+              0
+            )
+            == MAP_FAILED) {
+            std::print(
+              stderr,
+              "[ERROR] failed to map scrollback memory: {}\n",
+              strerror(errno)
+            );
+            munmap(reserved, 2 * size);
+            ::close(fd);
+            return nullptr;
+        }
+    }
+
+    // The mappings keep the memory alive.
+    ::close(fd);
+
+    return std::unique_ptr<Scrollback>(new Scrollback(data, size));
+}
+
+Scrollback::Scrollback(char *data, const std::size_t length)
+  : data(data),
+    length(length)
+{}
+
+Scrollback::~Scrollback() { munmap(data, 2 * length); }
+
+void Scrollback::append(std::span<const char> bytes)
+{
+    // Anything beyond a full ring would be evicted right away anyway.
+    while (!bytes.empty()) {
+        const auto count = std::min(bytes.size(), length);
+        evict(count);
+
+        auto *destination = data + (last % length);
+        std::memcpy(destination, bytes.data(), count);
+
+        // A line starts at the first byte after a newline, only index it
+        // once that byte actually arrived.
+        if (line_starts.empty()
+            || (last > first && *at(last - 1) == '\n')) {
+            line_starts.push_back(last);
+        }
+
+        const auto *cursor = destination;
+        const auto *stop   = destination + count;
+        while (true) {
+            const auto *newline = static_cast<const char *>(std::memchr(
+              cursor, '\n', static_cast<std::size_t>(stop - cursor)
+            ));
+            if (newline == nullptr || newline + 1 == stop) { break; }
+
+            cursor = newline + 1;
+            line_starts.push_back(
+              last + static_cast<std::uint64_t>(cursor - destination)
+            );
+        }
+
+        last += count;
+        bytes = bytes.subspan(count);
+    }
+}
+
+void Scrollback::clear()
+{
+    first = last;
+    line_starts.clear();
+}
+
+std::string_view Scrollback::line(const std::size_t index) const
+{
+    const auto begin = line_starts[index];
+    auto       end =
+      index + 1 < line_starts.size() ? line_starts[index + 1] : last;
+    if (end > begin && *at(end - 1) == '\n') { --end; }
+
+    return { at(begin), static_cast<std::size_t>(end - begin) };
+}
+
+void Scrollback::evict(const std::size_t bytes)
+{
+    if (size() + bytes <= length) { return; }
+
+    const auto needed = last + bytes - length;
+    while (!line_starts.empty() && line_starts.front() < needed) {
+        line_starts.pop_front();
+    }
+
+    first = needed;
+    if (line_starts.empty() && needed < last) {
+        // One line longer than the whole budget, keep its tail.
+        line_starts.push_back(needed);
+    } else if (!line_starts.empty()) {
+        first = line_starts.front();
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef SESAMO_SCROLLBACK_HPP
+#define SESAMO_SCROLLBACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <string_view>
+
+// Received text of one port, bounded to a fixed byte budget.
+//
+// Bytes live in a ring whose memory is mapped twice back to back, so any
+// run of up to `capacity()` bytes is contiguous no matter where it wraps
+// and lines can be handed out as plain string_views. The offset every line
+// starts at is indexed as bytes come in; once the budget is used up the
+// oldest whole lines are evicted by popping their index entries, nothing is
+// ever moved. Offsets are positions in the port's byte stream, they keep
+// counting across evictions and clear().
+class [[nodiscard]] Scrollback final
+{
+  public:
+    constexpr static std::size_t MIN_CAPACITY = 64ULL * 1024 * 1024;
+    constexpr static std::size_t MAX_CAPACITY = 4ULL * 1024 * 1024 * 1024;
+    constexpr static std::size_t DEFAULT_CAPACITY = MIN_CAPACITY;
+
+    // `capacity` is rounded up to whole pages. Returns nullptr when the ring
+    // could not be mapped.
+    [[nodiscard]] static auto create(const std::size_t capacity)
+      -> std::unique_ptr<Scrollback>;
+
+    ~Scrollback();
+
+    Scrollback(const Scrollback &)            = delete;
+    Scrollback &operator=(const Scrollback &) = delete;
+    Scrollback(Scrollback &&)                 = delete;
+    Scrollback &operator=(Scrollback &&)      = delete;
+
+    void append(std::span<const char> bytes);
+    void clear();
+
+    [[nodiscard]] std::size_t line_count() const noexcept
+    {
+        return line_starts.size();
+    }
+
+    // Line `index` without its trailing newline, the last line may still be
+    // incomplete and the first one may have lost its head if a single line
+    // outgrew the whole budget.
+    [[nodiscard]] std::string_view line(const std::size_t index) const;
+
+    [[nodiscard]] std::uint64_t line_offset(const std::size_t index) const
+    {
+        return line_starts[index];
+    }
+
+    // Stream offset of the oldest byte still kept.
+    [[nodiscard]] std::uint64_t begin() const noexcept { return first; }
+
+    // Stream offset right past the last byte received.
+    [[nodiscard]] std::uint64_t end() const noexcept { return last; }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return static_cast<std::size_t>(last - first);
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return length; }
+
+    // Bytes held plus the line index, the ring itself only costs the pages
+    // that were written to.
+    [[nodiscard]] std::size_t memory_usage() const noexcept
+    {
+        return size() + (line_starts.size() * sizeof(std::uint64_t));
+    }
+
+  private:
+    Scrollback(char *data, const std::size_t length);
+
+    char             *data   = nullptr;
+    const std::size_t length = 0;
+
+    std::uint64_t             first = 0;
+    std::uint64_t             last  = 0;
+    std::deque<std::uint64_t> line_starts;
+
+    // Makes room for `bytes` more bytes by evicting whole lines.
+    void evict(const std::size_t bytes);
+
+    [[nodiscard]] const char *at(const std::uint64_t offset) const noexcept
+    {
+        return data + (offset % length);
+    }
+};
+
+#endif // SESAMO_SCROLLBACK_HPP
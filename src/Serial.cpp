@@ -1,17 +1,222 @@
 #include "Serial.hpp"
+#include "Termios2.hpp"
+#include "Trace.hpp"
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
-#include <mutex>
+#include <format>
+#include <linux/serial.h>
+#include <span>
+#include <string_view>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
 #include <print>
 
-auto Serial::open(const std::filesystem::path &path, const int baud_rate)
-  -> std::optional<std::shared_ptr<Serial>>
+namespace
 {
+
+struct StandardBaudRate
+{
+    std::uint32_t rate;
+    speed_t       speed;
+};
+
+constexpr auto STANDARD_BAUD_RATES = std::to_array<StandardBaudRate>({
+  { 0, B0 },
+  { 50, B50 },
+  { 75, B75 },
+  { 110, B110 },
+  { 134, B134 },
+  { 150, B150 },
+  { 200, B200 },
+  { 300, B300 },
+  { 600, B600 },
+  { 1200, B1200 },
+  { 1800, B1800 },
+  { 2400, B2400 },
+  { 4800, B4800 },
+  { 9600, B9600 },
+  { 19200, B19200 },
+  { 38400, B38400 },
+  { 57600, B57600 },
+  { 115200, B115200 },
+  { 230400, B230400 },
+  { 460800, B460800 },
+  { 500000, B500000 },
+  { 576000, B576000 },
+  { 921600, B921600 },
+  { 1000000, B1000000 },
+  { 1152000, B1152000 },
+  { 1500000, B1500000 },
+  { 2000000, B2000000 },
+  { 2500000, B2500000 },
+  { 3000000, B3000000 },
+  { 3500000, B3500000 },
+  { 4000000, B4000000 },
+});
+
+[[nodiscard]] auto standard_speed(const std::uint32_t baud_rate)
+  -> std::optional<speed_t>
+{
+    const auto *const match = std::ranges::find(
+      STANDARD_BAUD_RATES, baud_rate, &StandardBaudRate::rate
+    );
+    if (match == STANDARD_BAUD_RATES.end()) { return std::nullopt; }
+    return match->speed;
+}
+
+constexpr int OPEN_FLAGS = O_RDWR | O_NOCTTY | O_SYNC | O_NONBLOCK | O_CLOEXEC;
+
+// udev names every USB serial adapter here after its vendor, product and
+// serial number, the name survives re-enumeration where ttyUSBn does not.
+constexpr std::string_view BY_ID_PATH = "/dev/serial/by-id";
+
+// The by-id link pointing at the same device as `path`, or `path` itself
+// if there is none.
+[[nodiscard]] std::filesystem::path
+  stable_identity(const std::filesystem::path &path)
+{
+    if (path.parent_path() == BY_ID_PATH) { return path; }
+
+    std::error_code error;
+    const auto      device = std::filesystem::canonical(path, error);
+    if (error) { return path; }
+
+    auto links = std::filesystem::directory_iterator(BY_ID_PATH, error);
+    for (; !error && links != std::filesystem::directory_iterator();
+         links.increment(error)) {
+        std::error_code ignored;
+        if (std::filesystem::canonical(links->path(), ignored) == device) {
+            return links->path();
+        }
+    }
+    return path;
+}
+
+[[nodiscard]] std::int64_t since_epoch(const auto now)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             now.time_since_epoch()
+    )
+      .count();
+}
+
+struct LineCounter
+{
+    std::uint64_t Serial::LineCounters::*field;
+    std::string_view                     name;
+};
+
+// Every counter, the errors among them with how describe_errors() calls
+// them.
+constexpr auto LINE_COUNTERS = std::to_array<LineCounter>({
+  { &Serial::LineCounters::rx, {} },
+  { &Serial::LineCounters::tx, {} },
+  { &Serial::LineCounters::overrun, "overrun" },
+  { &Serial::LineCounters::frame, "framing" },
+  { &Serial::LineCounters::parity, "parity" },
+  { &Serial::LineCounters::brk, "break" },
+  { &Serial::LineCounters::buffer_overrun, "buffer overrun" },
+});
+
+struct BackpressureName
+{
+    Serial::Backpressure policy;
+    std::string_view     name;
+};
+
+constexpr auto BACKPRESSURE_NAMES = std::to_array<BackpressureName>({
+  { Serial::Backpressure::DropNewest, "drop-newest" },
+  { Serial::Backpressure::DropOldest, "drop-oldest" },
+  { Serial::Backpressure::Block, "block" },
+  { Serial::Backpressure::Spill, "spill" },
+});
+
+// An unlinked file in `directory` that goes away with its fd, -1 (after
+// printing why) if none could be made. Not /tmp by default, that is often
+// a tmpfs and spilling to it would only move the memory elsewhere.
+[[nodiscard]] int open_spill_file(std::filesystem::path directory)
+{
+    if (directory.empty()) {
+        // NOLINTNEXTLINE(concurrency-mt-unsafe)
+        const auto *const tmpdir = std::getenv("TMPDIR");
+        directory = tmpdir != nullptr ? tmpdir : "/var/tmp";
+    }
+
+    // NOLINTNEXTLINE
+    const auto fd =
+      ::open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to create a spill file in {}: {}\n",
+          directory.string(),
+          strerror(errno)
+        );
+    }
+    return fd;
+}
+
+} // namespace
+
+auto Serial::parse_backpressure(const std::string_view name)
+  -> std::optional<Backpressure>
+{
+    const auto *const match =
+      std::ranges::find(BACKPRESSURE_NAMES, name, &BackpressureName::name);
+    if (match == BACKPRESSURE_NAMES.end()) { return std::nullopt; }
+    return match->policy;
+}
+
+std::string_view Serial::describe(const Backpressure policy)
+{
+    return std::ranges::find(
+             BACKPRESSURE_NAMES, policy, &BackpressureName::policy
+    )
+      ->name;
+}
+
+auto Serial::LineCounters::since(const LineCounters &before) const
+  -> LineCounters
+{
+    LineCounters increase;
+    for (const auto &[field, _] : LINE_COUNTERS) {
+        increase.*field = this->*field - before.*field;
+    }
+    return increase;
+}
+
+std::string Serial::LineCounters::describe_errors() const
+{
+    std::string text;
+    for (const auto &[field, name] : LINE_COUNTERS) {
+        if (name.empty() || this->*field == 0) { continue; }
+        text += std::format(
+          "{}{} {}", text.empty() ? "" : ", ", this->*field, name
+        );
+    }
+    return text;
+}
+
+auto Serial::open(
+  const std::filesystem::path    &path,
+  const std::uint32_t             baud_rate,
+  const std::shared_ptr<Reactor> &reactor,
+  const Buffering                &buffering
+) -> std::optional<std::shared_ptr<Serial>>
+{
+    const auto blocking = buffering.policy == Backpressure::Block;
+
     // NOLINTNEXTLINE
-    const auto fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_SYNC);
+    const auto fd = ::open(path.c_str(), OPEN_FLAGS);
     if (fd < 0) {
         std::print(
           stderr,
@@ -21,7 +226,47 @@ auto Serial::open(const std::filesystem::path &path, const int baud_rate)
         );
         return std::nullopt;
     }
+    if (!configure(fd, path, baud_rate, blocking)) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    auto spill_fd = -1;
+    if (buffering.policy == Backpressure::Spill) {
+        spill_fd = open_spill_file(buffering.spill_directory);
+        if (spill_fd < 0) {
+            ::close(fd);
+            return std::nullopt;
+        }
+    }
+
+    auto serial_instance =
+      std::shared_ptr<Serial>(new Serial(fd, buffering, spill_fd));
+    serial_instance->reactor     = reactor;
+    serial_instance->stable_path = stable_identity(path);
+    serial_instance->baud        = baud_rate;
+    serial_instance->driver_base = query_counters(fd);
+    serial_instance->connected.store(true, std::memory_order_relaxed);
+    if (!reactor->attach(serial_instance)) {
+        std::print(
+          stderr,
+          "[ERROR] failed to start reading from {}\n",
+          path.string()
+        );
+        serial_instance->connected.store(false, std::memory_order_relaxed);
+        return std::nullopt;
+    }
 
+    return serial_instance;
+}
+
+bool Serial::configure(
+  const int                    fd,
+  const std::filesystem::path &path,
+  const std::uint32_t          baud_rate,
+  const bool                   flow_control
+)
+{
     struct termios tty{};
     if (tcgetattr(fd, &tty) < 0) {
         std::print(
@@ -30,19 +275,28 @@ auto Serial::open(const std::filesystem::path &path, const int baud_rate)
           path.string(),
           strerror(errno)
         );
-        ::close(fd);
-        return std::nullopt;
+        return false;
     }
 
-    cfsetospeed(&tty, static_cast<speed_t>(baud_rate));
-    cfsetispeed(&tty, static_cast<speed_t>(baud_rate));
+    /* anything without a Bxxx constant goes through termios2 below */
+    const auto speed = standard_speed(baud_rate);
+    if (speed) {
+        cfsetospeed(&tty, *speed);
+        cfsetispeed(&tty, *speed);
+    }
 
     tty.c_cflag |= (CLOCAL | CREAD); /* ignore modem controls */
     tty.c_cflag &= ~CSIZE;
     tty.c_cflag |= CS8; /* 8-bit characters */
     tty.c_cflag &= ~PARENB; /* no parity bit */
     tty.c_cflag &= ~CSTOPB; /* only need 1 stop bit */
-    tty.c_cflag &= ~CRTSCTS; /* no hardware flowcontrol */
+    /* hardware flowcontrol only for ports that block, the tty then drops
+     * RTS once its buffer fills */
+    if (flow_control) {
+        tty.c_cflag |= CRTSCTS;
+    } else {
+        tty.c_cflag &= ~CRTSCTS;
+    }
 
     /* setup for non-canonical mode */
     tty.c_iflag &=
@@ -50,9 +304,10 @@ auto Serial::open(const std::filesystem::path &path, const int baud_rate)
     tty.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
     tty.c_oflag &= ~OPOST;
 
-    /* fetch bytes as they become available */
-    tty.c_cc[VMIN]  = 0;
-    tty.c_cc[VTIME] = 10; // Adjust timeout as needed
+    /* return whatever is available, together with O_NONBLOCK an empty
+     * buffer yields EAGAIN instead of a zero length read */
+    tty.c_cc[VMIN]  = 1;
+    tty.c_cc[VTIME] = 0;
 
     if (tcsetattr(fd, TCSANOW, &tty) != 0) {
         std::print(
@@ -61,70 +316,581 @@ auto Serial::open(const std::filesystem::path &path, const int baud_rate)
           path.string(),
           strerror(errno)
         );
-        ::close(fd);
-        return std::nullopt;
+        return false;
     }
 
-    auto serial_instance = std::shared_ptr<Serial>(new Serial(fd));
-    serial_instance->read_thread =
-      std::thread(&Serial::read_loop, serial_instance);
-    serial_instance->connected.store(true, std::memory_order_relaxed);
-    serial_instance->stop_reading.store(false, std::memory_order_relaxed);
+    if (!speed) {
+        const auto actual = set_arbitrary_baud_rate(fd, baud_rate);
+        if (!actual) {
+            std::print(
+              stderr,
+              "[ERROR] failed to set {} baud for {}: {}\n",
+              baud_rate,
+              path.string(),
+              strerror(errno)
+            );
+            return false;
+        }
 
-    return serial_instance;
+        if (*actual != baud_rate) {
+            std::print(
+              stderr,
+              "[WARNING] {} runs at {} baud, {} was requested\n",
+              path.string(),
+              *actual,
+              baud_rate
+            );
+        }
+    }
+
+    return true;
 }
 
-Serial::Serial(int fd)
+Serial::Serial(int fd, const Buffering &buffering, int spill_fd)
   : fd(fd),
     connected(false),
-    stop_reading(false)
+    // The ring rounds up to a power of two, the ceiling must not move.
+    read_buffer(std::make_unique<RingBuffer>(
+      std::bit_floor(std::max<std::size_t>(buffering.capacity, 1))
+    )),
+    arrivals(std::make_unique<RingBuffer>(
+      ARRIVAL_CAPACITY * sizeof(Timeline::Arrival)
+    )),
+    realtime(false),
+    dropped(0),
+    reads(0),
+    received(0),
+    gaps(std::make_unique<RingBuffer>(GAP_CAPACITY * sizeof(Gap))),
+    reconnect_enabled(false),
+    reconnecting(false),
+    reconnects(0),
+    resume_lag(0),
+    samples(std::make_unique<RingBuffer>(
+      SAMPLE_CAPACITY * sizeof(CounterSample)
+    )),
+    policy(buffering.policy),
+    behind(false),
+    pauses(0),
+    spilled(0),
+    backlog(0),
+    spill_fd(spill_fd),
+    spill_limit(buffering.spill_limit)
 {}
 
 Serial::~Serial() { close(); }
 
 void Serial::close()
 {
+    // Once detach() returns the reactor is done with our fd for good, a
+    // reconnect may still have got in before, so only then is the port
+    // down to stay.
+    if (const auto owner = reactor.lock()) { owner->detach(*this); }
+    reactor.reset();
+    connected.store(false, std::memory_order_relaxed);
+    reconnecting.store(false, std::memory_order_relaxed);
+
     if (fd >= 0) {
         ::close(fd);
         fd = -1;
     }
-    connected.store(false, std::memory_order_relaxed);
-    stop_reading.store(true, std::memory_order_relaxed);
-    if (read_thread.joinable()) { read_thread.join(); }
+    // Whatever was still spilled is gone with it.
+    if (spill_fd >= 0) {
+        ::close(spill_fd);
+        spill_fd = -1;
+    }
 }
 
-void Serial::read_loop()
+bool Serial::drain(const std::span<char> overflow)
 {
-    while (!stop_reading.load(std::memory_order_relaxed)) {
-        char       msg[256];
-        const auto bytes = ::read(fd, static_cast<char *>(msg), sizeof(msg));
+    // Bytes held back or spilled go first, new ones queue up behind them.
+    const auto caught_up = !has_backlog() || catch_up();
+
+    for (std::size_t i = 0; i < READS_PER_DRAIN; ++i) {
+        SESAMO_TRACE_SCOPE("serial.read");
+
+        // Read straight into the ring. Once it is full keep draining the
+        // kernel buffer anyway so epoll does not spin and let the
+        // Backpressure deal with it, unless that is to stop reading.
+        auto       destination = read_buffer->write_span();
+        const auto full        = destination.empty() || !caught_up;
+        if (full && policy == Backpressure::Block) {
+            behind.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        if (full) { destination = overflow; }
+
+        const auto requested = std::min(destination.size(), READ_CHUNK_SIZE);
+        const auto bytes     = ::read(fd, destination.data(), requested);
+        reads.fetch_add(1, std::memory_order_relaxed);
         if (bytes > 0) {
-            std::string received_data(static_cast<char *>(msg), bytes);
-            {
-                std::lock_guard<std::mutex> lock(read_buffer_mutex);
-                read_buffer.push_back(received_data);
+            const auto count = static_cast<size_t>(bytes);
+            const auto offset =
+              received.fetch_add(count, std::memory_order_relaxed);
+            const auto arrival = timestamp();
+            if (full) {
+                this->overflow(destination.first(count), arrival);
+            } else {
+                read_buffer->commit(count);
+                stored += count;
+                arrived(arrival);
             }
-        } else if (bytes < 0) {
+            if (recorder) {
+                tap(offset, arrival, destination.first(count));
+            }
+
+            // A short read means the kernel buffer is empty, skip the
+            // extra syscall that would only report EAGAIN.
+            if (count < requested) { return true; }
+        } else if (bytes == 0) {
+            std::print(stderr, "[ERROR] serial port hung up\n");
+            return false;
+        } else if (errno == EAGAIN) {
+            return true;
+        } else if (errno != EINTR) {
             std::print(
               stderr,
               "[ERROR] failed to read from serial port: {}\n",
               strerror(errno)
             );
-            // FIXME: Consider what to do on read error: try to reconnect, signal error, etc.
+            return false;
+        }
+    }
+
+    // Still more to read, epoll reports the fd again right away.
+    return true;
+}
+
+void Serial::store(std::span<const char> bytes)
+{
+    SESAMO_TRACE_SCOPE("serial.store");
+
+    const auto offset =
+      received.fetch_add(bytes.size(), std::memory_order_relaxed);
+    const auto arrival = timestamp();
+    if (recorder) { tap(offset, arrival, bytes); }
+
+    if (has_backlog() && !catch_up()) {
+        overflow(bytes, arrival);
+        return;
+    }
+
+    const auto count = push(bytes);
+    if (count > 0) { arrived(arrival); }
+    if (count < bytes.size()) { overflow(bytes.subspan(count), arrival); }
+}
+
+std::size_t Serial::push(std::span<const char> bytes)
+{
+    const auto before = stored;
+    while (!bytes.empty()) {
+        const auto destination = read_buffer->write_span();
+        if (destination.empty()) { break; }
+
+        const auto count = std::min(destination.size(), bytes.size());
+        std::memcpy(destination.data(), bytes.data(), count);
+        read_buffer->commit(count);
+        stored += count;
+        bytes   = bytes.subspan(count);
+    }
+    return stored - before;
+}
+
+void Serial::overflow(
+  const std::span<const char> bytes,
+  const Timeline::Arrival    &at
+)
+{
+    switch (policy) {
+        case Backpressure::DropNewest: {
+            dropped.fetch_add(bytes.size(), std::memory_order_relaxed);
+            break;
+        }
+        case Backpressure::DropOldest: {
+            // Only the last ring full of a read can be kept anyway.
+            auto kept =
+              bytes.last(std::min(bytes.size(), read_buffer->capacity()));
+            auto lost = bytes.size() - kept.size();
+
+            // The consumer may be reading the oldest bytes right now, then
+            // discard() leaves them and the newest bytes go after all.
+            const auto room = read_buffer->capacity() - read_buffer->size();
+            if (kept.size() > room) {
+                lost += read_buffer->discard(kept.size() - room);
+            }
+
+            const auto pushed = push(kept);
+            if (pushed > 0) { arrived(at); }
+            lost += kept.size() - pushed;
+            dropped.fetch_add(lost, std::memory_order_relaxed);
+            break;
+        }
+        case Backpressure::Block: {
+            // What io_uring read before the reactor could stop it, bounded
+            // by its shared buffers.
+            held.insert(held.end(), bytes.begin(), bytes.end());
+            held_at = at;
+            behind.store(true, std::memory_order_relaxed);
+            backlog.fetch_add(bytes.size(), std::memory_order_relaxed);
+            break;
+        }
+        case Backpressure::Spill: {
+            if (!spill(bytes, at)) {
+                dropped.fetch_add(bytes.size(), std::memory_order_relaxed);
+            }
+            break;
+        }
+    }
+}
+
+bool Serial::spill(
+  const std::span<const char> bytes,
+  const Timeline::Arrival    &arrival
+)
+{
+    // Against what the file takes up on disk, not just what is unread.
+    if (spill_fd < 0
+        || spill_end - spill_freed + sizeof(SpillFrame) + bytes.size()
+             > spill_limit) {
+        return false;
+    }
+
+    // Each read with its timestamps, so they survive the detour.
+    SpillFrame header{ .monotonic = arrival.monotonic,
+                       .realtime  = arrival.realtime,
+                       .size      = bytes.size() };
+    const auto parts = std::to_array<iovec>({
+      { &header, sizeof(header) },
+      // NOLINTNEXTLINE
+      { const_cast<char *>(bytes.data()), bytes.size() },
+    });
+    const auto written = pwritev(
+      spill_fd,
+      parts.data(),
+      static_cast<int>(parts.size()),
+      static_cast<off_t>(spill_end)
+    );
+    if (written != static_cast<ssize_t>(sizeof(header) + bytes.size())) {
+        std::print(
+          stderr,
+          "[ERROR] failed to spill to disk, dropping from now on: {}\n",
+          written < 0 ? strerror(errno) : "short write"
+        );
+        ::close(spill_fd);
+        spill_fd = -1;
+        return false;
+    }
+
+    spill_end += sizeof(header) + bytes.size();
+    spilled.fetch_add(bytes.size(), std::memory_order_relaxed);
+    backlog.fetch_add(bytes.size(), std::memory_order_relaxed);
+    behind.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool Serial::catch_up()
+{
+    if (!held.empty()) {
+        const auto count = push(held);
+        if (count > 0) { arrived(held_at); }
+        held.erase(
+          held.begin(), held.begin() + static_cast<std::ptrdiff_t>(count)
+        );
+        backlog.fetch_sub(count, std::memory_order_relaxed);
+        if (!held.empty()) { return false; }
+    }
+
+    // Whatever the file still held is lost if it fails.
+    const auto failed = [this] {
+        std::print(stderr, "[ERROR] failed to read back spilled bytes\n");
+        ::close(spill_fd);
+        spill_fd = -1;
+        dropped.fetch_add(
+          backlog.exchange(0, std::memory_order_relaxed),
+          std::memory_order_relaxed
+        );
+        spill_begin = spill_end;
+    };
+
+    while (spill_begin != spill_end) {
+        if (frame.size == 0) {
+            // NOLINTNEXTLINE
+            if (pread(
+                  spill_fd,
+                  &frame,
+                  sizeof(frame),
+                  static_cast<off_t>(spill_begin)
+                )
+                != sizeof(frame)) {
+                failed();
+                break;
+            }
+            spill_begin += sizeof(frame);
+        }
+
+        const auto destination = read_buffer->write_span();
+        if (destination.empty()) {
+            free_spilled();
+            return false;
+        }
+
+        const auto count = std::min<std::uint64_t>(
+          destination.size(), frame.size
+        );
+        const auto bytes = pread(
+          spill_fd,
+          destination.data(),
+          static_cast<std::size_t>(count),
+          static_cast<off_t>(spill_begin)
+        );
+        if (bytes <= 0) {
+            failed();
             break;
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        const auto read = static_cast<std::uint64_t>(bytes);
+        read_buffer->commit(static_cast<std::size_t>(read));
+        stored      += read;
+        spill_begin += read;
+        frame.size  -= read;
+        backlog.fetch_sub(read, std::memory_order_relaxed);
+        arrived({ .end       = 0,
+                  .monotonic = frame.monotonic,
+                  .realtime  = frame.realtime });
+    }
+
+    // Caught up, the file starts over instead of growing for good.
+    if (spill_end != 0) {
+        if (spill_fd >= 0 && ftruncate(spill_fd, 0) != 0) {
+            std::print(
+              stderr,
+              "[WARNING] failed to truncate the spill file: {}\n",
+              strerror(errno)
+            );
+        }
+        spill_begin = 0;
+        spill_end   = 0;
+        spill_freed = 0;
+        frame       = {};
+    }
+    return true;
+}
+
+void Serial::free_spilled()
+{
+    // A consumer that keeps up only partly never lets the file start over,
+    // so what was fed back gives its disk back right away. Without hole
+    // punching (some filesystems) it keeps counting towards the limit. Only
+    // whole blocks are given back, the one being read stays.
+    constexpr std::uint64_t HOLE_GRANULARITY = 4096;
+
+    const auto until = spill_begin / HOLE_GRANULARITY * HOLE_GRANULARITY;
+    if (spill_fd < 0 || until <= spill_freed) { return; }
+    if (fallocate(
+          spill_fd,
+          FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+          static_cast<off_t>(spill_freed),
+          static_cast<off_t>(until - spill_freed)
+        )
+        == 0) {
+        spill_freed = until;
+    }
+}
+
+void Serial::made_room() const
+{
+    if (const auto owner = reactor.lock()) { owner->resume_reading(); }
+}
+
+void Serial::lose()
+{
+    // A gap in the recording right where the stream continues, at the time
+    // the port went away, so it shows even if the device never returns.
+    lost_at = timestamp();
+    if (recorder) {
+        capture::RecordHeader gap;
+        gap.port      = recorder_port;
+        gap.offset    = received.load(std::memory_order_relaxed);
+        gap.monotonic = lost_at.monotonic;
+        gap.realtime  = lost_at.realtime;
+        recorder->append_gap(gap);
+    }
+
+    reconnecting.store(true, std::memory_order_relaxed);
+    connected.store(false, std::memory_order_relaxed);
+    ::close(fd);
+    fd = -1;
+
+    // The device may well count from zero again once it is back.
+    carried = totals;
+    driver_base.reset();
+
+    // A port that keeps failing right after it came back does not get to
+    // hammer the device with reopens.
+    const auto now = Clock::now();
+    backoff        = now - resumed_at >= RECONNECT_BACKOFF_MAX
+                       ? RECONNECT_BACKOFF
+                       : std::min(backoff * 2, RECONNECT_BACKOFF_MAX);
+    last_attempt   = now;
+    retry_at       = now + backoff;
+}
+
+bool Serial::reopen()
+{
+    // Quietly, the device node is usually not back yet or udev did not get
+    // to its permissions.
+    // NOLINTNEXTLINE
+    const auto reopened = ::open(stable_path.c_str(), OPEN_FLAGS);
+    const auto now      = Clock::now();
+    if (reopened < 0
+        || !configure(
+          reopened, stable_path, baud, policy == Backpressure::Block
+        )) {
+        if (reopened >= 0) { ::close(reopened); }
+        backoff      = std::min(backoff * 2, RECONNECT_BACKOFF_MAX);
+        last_attempt = now;
+        retry_at     = now + backoff;
+        return false;
+    }
+
+    fd          = reopened;
+    resumed_at  = now;
+    driver_base = query_counters(fd);
+
+    // The device showed up some time after the previous attempt, which
+    // bounds how long it waited for us.
+    const auto lag = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       now - last_attempt
+    )
+                       .count();
+    if (lag > resume_lag.load(std::memory_order_relaxed)) {
+        resume_lag.store(lag, std::memory_order_relaxed);
+    }
+    reconnects.fetch_add(1, std::memory_order_relaxed);
+
+    [[maybe_unused]] const auto _ = gaps->write_record(Gap{
+      .end     = stored,
+      .lost    = lost_at.monotonic,
+      .resumed = since_epoch(now),
+    });
+
+    connected.store(true, std::memory_order_relaxed);
+    reconnecting.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+bool Serial::poll_counters()
+{
+    if (!driver_base) { return false; }
+    const auto current = query_counters(fd);
+    if (!current) { return false; }
+
+    // The driver's counters are 32 bit and wrap around.
+    for (const auto &[field, _] : LINE_COUNTERS) {
+        totals.*field = carried.*field
+                        + static_cast<std::uint32_t>(
+                          (*current).*field - (*driver_base).*field
+                        );
+    }
+    if (totals == published && (!recorder || totals == recorded)) {
+        return false;
+    }
+
+    const auto now = timestamp();
+    if (recorder && totals != recorded) {
+        capture::RecordHeader header;
+        header.port      = recorder_port;
+        header.offset    = received.load(std::memory_order_relaxed);
+        header.monotonic = now.monotonic;
+        header.realtime  = now.realtime;
+        recorder->append_counters(
+          header,
+          capture::Counters{ .rx             = totals.rx,
+                             .tx             = totals.tx,
+                             .overrun        = totals.overrun,
+                             .frame          = totals.frame,
+                             .parity         = totals.parity,
+                             .brk            = totals.brk,
+                             .buffer_overrun = totals.buffer_overrun }
+        );
+        recorded = totals;
     }
+
+    // A consumer that is behind gets the then latest totals next time.
+    if (totals == published
+        || !samples->write_record(CounterSample{
+          .end = stored, .monotonic = now.monotonic, .counters = totals
+        })) {
+        return false;
+    }
+    published = totals;
+    return true;
 }
 
-std::vector<std::string> Serial::read_all()
+auto Serial::query_counters(const int fd) -> std::optional<LineCounters>
 {
-    std::vector<std::string> temp_buffer;
-    {
-        std::lock_guard<std::mutex> lock(read_buffer_mutex);
-        temp_buffer = read_buffer;
+    serial_icounter_struct count{};
+    // NOLINTNEXTLINE
+    if (ioctl(fd, TIOCGICOUNT, &count) < 0) { return std::nullopt; }
+
+    const auto value = [](const int counter) {
+        return std::uint64_t{ static_cast<std::uint32_t>(counter) };
+    };
+    return LineCounters{ .rx             = value(count.rx),
+                         .tx             = value(count.tx),
+                         .overrun        = value(count.overrun),
+                         .frame          = value(count.frame),
+                         .parity         = value(count.parity),
+                         .brk            = value(count.brk),
+                         .buffer_overrun = value(count.buf_overrun) };
+}
+
+bool Serial::record(
+  std::shared_ptr<CaptureWriter> writer,
+  const std::uint16_t            port
+)
+{
+    const auto owner = reactor.lock();
+    if (!owner) { return false; }
+
+    return owner->execute([this, &writer, port] {
+        recorder      = std::move(writer);
+        recorder_port = port;
+        // A new recording starts with the current counters.
+        recorded.reset();
+    });
+}
+
+Timeline::Arrival Serial::timestamp() const
+{
+    // steady_clock and system_clock are CLOCK_MONOTONIC and CLOCK_REALTIME,
+    // both served from the vDSO without entering the kernel.
+    Timeline::Arrival arrival{
+        .end       = 0,
+        .monotonic = since_epoch(std::chrono::steady_clock::now()),
+        .realtime  = 0,
+    };
+    if (realtime.load(std::memory_order_relaxed) || recorder) {
+        arrival.realtime = since_epoch(std::chrono::system_clock::now());
     }
-    read_buffer.clear();
-    return temp_buffer;
+    return arrival;
+}
+
+void Serial::arrived(Timeline::Arrival arrival)
+{
+    arrival.end                   = stored;
+    [[maybe_unused]] const auto _ = arrivals->write_record(arrival);
+}
+
+void Serial::tap(
+  const std::uint64_t         offset,
+  const Timeline::Arrival    &arrival,
+  const std::span<const char> bytes
+)
+{
+    capture::RecordHeader chunk;
+    chunk.port      = recorder_port;
+    chunk.offset    = offset;
+    chunk.monotonic = arrival.monotonic;
+    chunk.realtime  = arrival.realtime;
+    recorder->append(chunk, bytes);
 }
@@ -2,57 +2,466 @@
 #define SESAMO_SERIAL_HPP
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "CaptureWriter.hpp"
+#include "Reactor.hpp"
+#include "RingBuffer.hpp"
+#include "Timeline.hpp"
+#include "Trace.hpp"
+
 class [[nodiscard]] Serial final
 {
   public:
-    static auto open(const std::filesystem::path &path, const int baud_rate)
-      -> std::optional<std::shared_ptr<Serial>>;
+    struct Stats
+    {
+        std::uint64_t reads    = 0;
+        std::uint64_t received = 0;
+        // Times the port came back after it went away, and the longest it
+        // took to resume once its device was there again.
+        std::uint64_t            reconnects = 0;
+        std::chrono::nanoseconds resume_lag{ 0 };
+        // Times the port stopped reading because its consumer fell behind,
+        // bytes that went through the spill file and what still waits
+        // there (or, blocked, in memory) for room in the read buffer.
+        std::uint64_t pauses  = 0;
+        std::uint64_t spilled = 0;
+        std::uint64_t backlog = 0;
+    };
+
+    // The port went away at `lost` and was back at `resumed`, both
+    // CLOCK_MONOTONIC. `end` counts the bytes read_all() delivered before.
+    struct Gap
+    {
+        std::uint64_t end     = 0;
+        std::int64_t  lost    = 0;
+        std::int64_t  resumed = 0;
+    };
+
+    // Counters the tty driver keeps for the line (TIOCGICOUNT), summed over
+    // every time the port was opened since Serial::open.
+    struct LineCounters
+    {
+        std::uint64_t rx = 0;
+        std::uint64_t tx = 0;
+        // The UART's receive FIFO overran, a character failed its framing
+        // or parity check, a break arrived.
+        std::uint64_t overrun = 0;
+        std::uint64_t frame   = 0;
+        std::uint64_t parity  = 0;
+        std::uint64_t brk     = 0;
+        // The tty layer had no room left for what the driver received.
+        std::uint64_t buffer_overrun = 0;
+
+        [[nodiscard]] std::uint64_t errors() const noexcept
+        {
+            return overrun + frame + parity + brk + buffer_overrun;
+        }
+
+        // By how much each counter went up since `before`.
+        [[nodiscard]] LineCounters since(const LineCounters &before) const;
+
+        // The error counters that are not zero, e.g. "3 overrun, 1 framing".
+        [[nodiscard]] std::string describe_errors() const;
+
+        bool operator==(const LineCounters &) const = default;
+    };
+
+    // The counters as of CLOCK_MONOTONIC `monotonic`, `end` counts the
+    // bytes read_all() delivered before.
+    struct CounterSample
+    {
+        std::uint64_t end       = 0;
+        std::int64_t  monotonic = 0;
+        LineCounters  counters;
+    };
+
+    // How often the reactor polls the counters of every port whose driver
+    // keeps them, one ioctl per port.
+    constexpr static std::chrono::milliseconds COUNTER_INTERVAL{ 100 };
+
+    // A port that went away is reopened after this long at first, then
+    // twice as long after every failed attempt up to the maximum, which
+    // bounds how long it takes to resume once the device is back.
+    constexpr static std::chrono::milliseconds RECONNECT_BACKOFF{ 10 };
+    constexpr static std::chrono::milliseconds RECONNECT_BACKOFF_MAX{ 250 };
+
+    // Bytes a port may buffer ahead of its consumer before its
+    // Backpressure kicks in. This is the fixed per-port budget, about a
+    // second of a 10 Mbaud link.
+    constexpr static std::size_t DEFAULT_READ_BUFFER_CAPACITY = 1024 * 1024;
+
+    // Disk a spilling port may fill before it drops the newest bytes.
+    constexpr static std::uint64_t DEFAULT_SPILL_LIMIT =
+      std::uint64_t{ 1024 } * 1024 * 1024;
+
+    // What a port does with bytes that arrive while its read buffer is full
+    // because the consumer fell behind, say a minimized window or a stalled
+    // pipe.
+    enum class Backpressure : std::uint8_t
+    {
+        // Lose what arrives until there is room again.
+        DropNewest,
+        // Make room by giving up the oldest bytes the consumer did not get
+        // to, it always sees the latest.
+        DropOldest,
+        // Stop reading: the tty buffer fills up and, with RTS/CTS wired,
+        // the device is told to hold off. Nothing is lost on this side.
+        Block,
+        // Keep reading into a file on disk and feed it back in order once
+        // there is room, up to a limit.
+        Spill,
+    };
+
+    struct Buffering
+    {
+        Backpressure policy = Backpressure::DropNewest;
+        // Hard ceiling on the memory the port buffers for its consumer,
+        // rounded down to a power of two.
+        std::size_t capacity = DEFAULT_READ_BUFFER_CAPACITY;
+        // Where Spill keeps its (unlinked) file, $TMPDIR or /var/tmp if
+        // empty, and how much it may hold before dropping after all.
+        std::filesystem::path spill_directory;
+        std::uint64_t         spill_limit = DEFAULT_SPILL_LIMIT;
+    };
+
+    // "drop-newest", "drop-oldest", "block" and "spill".
+    [[nodiscard]] static std::optional<Backpressure>
+      parse_backpressure(std::string_view name);
+    [[nodiscard]] static std::string_view describe(Backpressure policy);
+
+    // `baud_rate` is in bits per second, rates without a Bxxx constant are
+    // programmed through termios2/BOTHER. The port is read by `reactor`
+    // until it is closed.
+    //
+    // A device with a /dev/serial/by-id link is reopened through that link
+    // when reconnecting, USB adapters rarely get their old ttyUSBn back.
+    static auto open(
+      const std::filesystem::path    &path,
+      const std::uint32_t             baud_rate,
+      const std::shared_ptr<Reactor> &reactor,
+      const Buffering                &buffering
+    ) -> std::optional<std::shared_ptr<Serial>>;
+
+    // With the default Buffering.
+    static auto open(
+      const std::filesystem::path    &path,
+      const std::uint32_t             baud_rate,
+      const std::shared_ptr<Reactor> &reactor
+    ) -> std::optional<std::shared_ptr<Serial>>
+    {
+        return open(path, baud_rate, reactor, Buffering{});
+    }
 
     ~Serial();
 
     Serial(const Serial &serial)            = delete;
     Serial &operator=(const Serial &serial) = delete;
+    Serial(Serial &&other)                  = delete;
+    Serial &operator=(Serial &&other)       = delete;
 
-    Serial(Serial &&other) noexcept
+    void close();
+
+    // Hands every byte received so far to `consumer` as (at most two)
+    // contiguous `std::span<const char>` views straight into the ring and
+    // releases them once the consumer returns. Returns the bytes consumed.
+    template <typename Consumer>
+    std::size_t read_all(Consumer &&consumer)
     {
-        swap(*this, other);
+        return read_all(std::forward<Consumer>(consumer), [](std::size_t) {});
     }
 
-    Serial &operator=(Serial &&other) noexcept
+    // Same, but with DropOldest first tells `on_discarded` how many bytes
+    // were given up since the last call. They count towards the offsets
+    // arrivals, gaps and counter samples are reported at.
+    template <typename Consumer, typename OnDiscarded>
+    std::size_t read_all(Consumer &&consumer, OnDiscarded &&on_discarded)
     {
-        swap(*this, other);
-        return *this;
+        SESAMO_TRACE_SCOPE("serial.read_all");
+        const auto consumed = read_buffer->read_all(
+          std::forward<Consumer>(consumer),
+          std::forward<OnDiscarded>(on_discarded)
+        );
+        // A blocked or spilling port waits to hear there is room again.
+        if (behind.load(std::memory_order_relaxed)) { made_room(); }
+        return consumed;
     }
 
-    void close();
+    // Hands `consumer` the receive time of every read since the last call,
+    // `Timeline::Arrival::end` counts the bytes read_all() delivers.
+    template <typename Consumer>
+    std::size_t read_arrivals(Consumer &&consumer)
+    {
+        return arrivals->read_records<Timeline::Arrival>(
+          std::forward<Consumer>(consumer)
+        );
+    }
 
-    [[nodiscard]] std::vector<std::string> read_all();
+    // Hands `consumer` every Gap since the last call. Call it before
+    // read_all(), so gaps ahead of the bytes read are already known.
+    template <typename Consumer>
+    std::size_t read_gaps(Consumer &&consumer)
+    {
+        return gaps->read_records<Gap>(std::forward<Consumer>(consumer));
+    }
+
+    // Hands `consumer` every CounterSample since the last call, a poll only
+    // makes one when a counter moved. Call it before read_all(), like
+    // read_gaps(). Ptys and other drivers without counters never have any.
+    template <typename Consumer>
+    std::size_t read_counters(Consumer &&consumer)
+    {
+        return samples->read_records<CounterSample>(
+          std::forward<Consumer>(consumer)
+        );
+    }
+
+    // CLOCK_MONOTONIC is always captured, CLOCK_REALTIME only on request.
+    void capture_realtime(const bool enabled) noexcept
+    {
+        realtime.store(enabled, std::memory_order_relaxed);
+    }
+
+    // Appends everything the port receives from now on to `writer` as
+    // `port`, nullptr stops recording. Bytes the consumer is too slow for
+    // are still recorded.
+    [[nodiscard]] bool
+      record(std::shared_ptr<CaptureWriter> writer, std::uint16_t port);
+
+    // Keep the port, its buffers and its recording when the device goes
+    // away and reopen it with backoff, instead of giving up on the first
+    // read error or hangup.
+    void reconnect(const bool enabled) noexcept
+    {
+        reconnect_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool is_connected() const noexcept
+    {
+        return connected.load(std::memory_order_relaxed);
+    }
+
+    // Whether the device went away and the reactor keeps trying to reopen
+    // it.
+    [[nodiscard]] bool is_reconnecting() const noexcept
+    {
+        return reconnecting.load(std::memory_order_relaxed);
+    }
+
+    // The path the port is reopened by.
+    [[nodiscard]] const std::filesystem::path &identity() const noexcept
+    {
+        return stable_path;
+    }
+
+    [[nodiscard]] Backpressure backpressure() const noexcept
+    {
+        return policy;
+    }
+
+    // Whether the port stopped reading or has bytes waiting for room in its
+    // read buffer, until read_all() lets it catch up.
+    [[nodiscard]] bool is_behind() const noexcept
+    {
+        return behind.load(std::memory_order_relaxed);
+    }
+
+    // Every byte received that the consumer will never get, whichever end
+    // of the stream it was lost from.
+    [[nodiscard]] std::uint64_t dropped_bytes() const noexcept
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] Stats stats() const noexcept
+    {
+        return { .reads      = reads.load(std::memory_order_relaxed),
+                 .received   = received.load(std::memory_order_relaxed),
+                 .reconnects = reconnects.load(std::memory_order_relaxed),
+                 .resume_lag = std::chrono::nanoseconds(
+                   resume_lag.load(std::memory_order_relaxed)
+                 ),
+                 .pauses     = pauses.load(std::memory_order_relaxed),
+                 .spilled    = spilled.load(std::memory_order_relaxed),
+                 .backlog    = backlog.load(std::memory_order_relaxed) };
+    }
 
   private:
-    explicit Serial(int fd);
+    friend class Reactor;
+
+    Serial(int fd, const Buffering &buffering, int spill_fd);
 
-    friend void swap(Serial& lhs, Serial& rhs) noexcept
+    // Puts an open tty into raw 8N1 at `baud_rate`, with RTS/CTS if
+    // `flow_control`, false (after printing why) if it refused.
+    [[nodiscard]] static bool configure(
+      int                          fd,
+      const std::filesystem::path &path,
+      std::uint32_t                baud_rate,
+      bool                         flow_control
+    );
+
+    // Upper bound for a single ::read, the reader keeps reading until the
+    // kernel tty buffer is empty so this only bounds the syscall size.
+    constexpr static std::size_t READ_CHUNK_SIZE = 64 * 1024;
+
+    // Full reads drain() does in one go before it lets the reactor serve
+    // other ports and commands (a close() among them). Epoll is level
+    // triggered, so the rest is picked up by the next round.
+    constexpr static std::size_t READS_PER_DRAIN = 16;
+
+    // Reads the UI may lag behind on before timestamps start to coalesce,
+    // bytes of a read that finds the queue full get the next read's time.
+    constexpr static std::size_t ARRIVAL_CAPACITY = 4096;
+
+    // Reconnects the UI may lag behind on, more are only counted.
+    constexpr static std::size_t GAP_CAPACITY = 64;
+
+    // Counter samples the UI may lag behind on, a poll that finds the queue
+    // full tries again on the next one.
+    constexpr static std::size_t SAMPLE_CAPACITY = 64;
+
+    int                         fd = -1;
+    std::weak_ptr<Reactor>      reactor;
+    std::uint64_t               reactor_id = 0;
+    std::atomic<bool>           connected;
+    std::unique_ptr<RingBuffer> read_buffer;
+    std::unique_ptr<RingBuffer> arrivals;
+    std::uint64_t               stored = 0;
+    std::atomic<bool>           realtime;
+    std::atomic<std::uint64_t>  dropped;
+    std::atomic<std::uint64_t>  reads;
+    std::atomic<std::uint64_t>  received;
+
+    std::filesystem::path       stable_path;
+    std::uint32_t               baud        = 0;
+    std::unique_ptr<RingBuffer> gaps;
+    std::atomic<bool>           reconnect_enabled;
+    std::atomic<bool>           reconnecting;
+    std::atomic<std::uint64_t>  reconnects;
+    std::atomic<std::int64_t>   resume_lag;
+    std::unique_ptr<RingBuffer> samples;
+
+    const Backpressure         policy;
+    std::atomic<bool>          behind;
+    std::atomic<std::uint64_t> pauses;
+    std::atomic<std::uint64_t> spilled;
+    std::atomic<std::uint64_t> backlog;
+
+    // Only ever touched by the reactor thread.
+    std::shared_ptr<CaptureWriter> recorder;
+    std::uint16_t                  recorder_port = 0;
+    // Whether the reactor mlock()ed the rings above.
+    bool locked = false;
+
+    // Reconnect state, also the reactor thread's alone.
+    using Clock = std::chrono::steady_clock;
+    Timeline::Arrival         lost_at;
+    Clock::time_point         last_attempt;
+    Clock::time_point         retry_at;
+    Clock::time_point         resumed_at;
+    std::chrono::milliseconds backoff = RECONNECT_BACKOFF;
+
+    // Counter state, the reactor thread's too. What the driver reported
+    // when the fd was opened (nullopt if it keeps no counters), the totals
+    // from before the port last went away, the latest totals and the last
+    // ones queued for the consumer and recorded.
+    std::optional<LineCounters> driver_base;
+    LineCounters                carried;
+    LineCounters                totals;
+    std::optional<LineCounters> published;
+    std::optional<LineCounters> recorded;
+
+    // Backpressure state, the reactor thread's as well. Whether the reactor
+    // stopped reading the fd; what a blocked port read before it could stop
+    // (io_uring reads land whether there is room or not) and when; the
+    // spill file with the range of it still to feed back, where the disk
+    // it takes up starts (what was fed back before is punched out), and
+    // what is left of the frame being fed back.
+    struct SpillFrame
+    {
+        std::int64_t  monotonic = 0;
+        std::int64_t  realtime  = 0;
+        std::uint64_t size      = 0;
+    };
+    bool              paused = false;
+    std::vector<char> held;
+    Timeline::Arrival held_at;
+    int               spill_fd = -1;
+    std::uint64_t     spill_limit = 0;
+    std::uint64_t     spill_begin = 0;
+    std::uint64_t     spill_end   = 0;
+    std::uint64_t     spill_freed = 0;
+    SpillFrame        frame;
+
+    // Called on the reactor thread. drain() reads the fd until the kernel
+    // buffer is empty or READS_PER_DRAIN reads were done and returns false
+    // once the port failed, store() takes bytes the io_uring backend
+    // already read.
+    [[nodiscard]] bool drain(std::span<char> overflow);
+    void               store(std::span<const char> bytes);
+
+    // Called on the reactor thread. push() copies what fits of `bytes` into
+    // the ring and returns how much did, overflow() applies the
+    // Backpressure to the rest. catch_up() moves held or spilled bytes into
+    // the ring and returns whether none are left, must_pause() tells the
+    // reactor to stop reading the fd for now.
+    [[nodiscard]] std::size_t push(std::span<const char> bytes);
+    void overflow(std::span<const char> bytes, const Timeline::Arrival &at);
+    [[nodiscard]] bool spill(
+      std::span<const char>    bytes,
+      const Timeline::Arrival &arrival
+    );
+    [[nodiscard]] bool catch_up();
+    void               free_spilled();
+    [[nodiscard]] bool has_backlog() const noexcept
+    {
+        return !held.empty() || spill_begin != spill_end;
+    }
+    [[nodiscard]] bool must_pause() const noexcept
     {
-        lhs.connected    = rhs.connected.load(std::memory_order_relaxed);
-        lhs.stop_reading = rhs.stop_reading.load(std::memory_order_relaxed);
-        std::swap(lhs.fd, rhs.fd);
-        std::swap(lhs.read_thread, rhs.read_thread);
+        return policy == Backpressure::Block
+               && (!held.empty()
+                   || read_buffer->size() == read_buffer->capacity());
     }
 
-    int                      fd = -1;
-    std::atomic<bool>        connected;
-    std::thread              read_thread;
-    std::mutex               read_buffer_mutex;
-    std::vector<std::string> read_buffer;
-    std::atomic<bool>        stop_reading;
+    // Consumer side, wakes the reactor to catch up once read_all() made
+    // room.
+    void made_room() const;
+
+    // Called on the reactor thread. lose() closes the fd of a port that
+    // failed and schedules the first attempt at `retry_at`, reopen() makes
+    // one and either resumes the port or pushes `retry_at` back.
+    void               lose();
+    [[nodiscard]] bool reopen();
+
+    // Called on the reactor thread every COUNTER_INTERVAL, queues a sample
+    // (and records it) when a counter moved and returns whether it did.
+    // query_counters() is nullopt if the driver keeps none.
+    [[nodiscard]] bool poll_counters();
+    [[nodiscard]] bool has_counters() const noexcept
+    {
+        return driver_base.has_value();
+    }
+    [[nodiscard]] static std::optional<LineCounters> query_counters(int fd);
 
-    void read_loop();
+    // When a read returned, arrived() queues it for the consumer once its
+    // bytes are stored and tap() records the read starting at `offset`.
+    [[nodiscard]] Timeline::Arrival timestamp() const;
+    void                            arrived(Timeline::Arrival arrival);
+    void tap(
+      std::uint64_t            offset,
+      const Timeline::Arrival &arrival,
+      std::span<const char>    bytes
+    );
 };
 
 #endif // SESAMO_SERIAL_HPP
@@ -0,0 +1,224 @@
+#include "Synthetic.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <iterator>
+#include <poll.h>
+#include <random>
+#include <termios.h>
+#include <unistd.h>
+#include <print>
+
+namespace
+{
+
+constexpr std::size_t LINE_WIDTH = 80;
+
+[[nodiscard]] std::vector<char>
+  generate(const Synthetic::Pattern pattern, const std::size_t size)
+{
+    constexpr auto LEVELS = std::to_array<std::string_view>({
+      "\x1b[32mINFO \x1b[0m",
+      "\x1b[36mDEBUG\x1b[0m",
+      "\x1b[33mWARN \x1b[0m",
+      "\x1b[31mERROR\x1b[0m",
+    });
+
+    // Fixed seed, two runs at the same rate produce the same stream.
+    std::mt19937_64 random(0x5e5a30);
+
+    std::vector<char> bytes;
+    bytes.reserve(size + LINE_WIDTH);
+    auto out = std::back_inserter(bytes);
+    for (std::uint64_t line = 0; bytes.size() < size; ++line) {
+        const auto millis = line * 7;
+        switch (pattern) {
+            case Synthetic::Pattern::Lines: {
+                const auto start = bytes.size();
+                std::format_to(out, "{:09} ", line);
+                while (bytes.size() - start < LINE_WIDTH - 1) {
+                    bytes.push_back(
+                      static_cast<char>('a' + ((bytes.size() - start) % 26))
+                    );
+                }
+                bytes.push_back('\n');
+                break;
+            }
+            case Synthetic::Pattern::Binary: {
+                for (std::size_t i = 0; i < LINE_WIDTH; ++i) {
+                    bytes.push_back(static_cast<char>(random() & 0xffU));
+                }
+                break;
+            }
+            case Synthetic::Pattern::Ansi: {
+                std::format_to(
+                  out,
+                  "{:02}:{:02}:{:02}.{:03} {} worker{}: request {} took {} "
+                  "ms\n",
+                  (millis / 3'600'000) % 24,
+                  (millis / 60'000) % 60,
+                  (millis / 1'000) % 60,
+                  millis % 1'000,
+                  LEVELS[random() % LEVELS.size()],
+                  random() % 8,
+                  line,
+                  random() % 250
+                );
+                break;
+            }
+            case Synthetic::Pattern::Csv: {
+                std::uniform_real_distribution<double> noise(-0.5, 0.5);
+                std::format_to(
+                  out,
+                  "{},{}.{:03},{:.3f},{:.3f},{:.3f}\n",
+                  line,
+                  millis / 1'000,
+                  millis % 1'000,
+                  21.0 + noise(random),
+                  1013.25 + (10 * noise(random)),
+                  45.0 + (5 * noise(random))
+                );
+                break;
+            }
+        }
+    }
+
+    return bytes;
+}
+
+} // namespace
+
+auto Synthetic::parse(const std::string_view name) -> std::optional<Pattern>
+{
+    const auto match = std::ranges::find(
+      PATTERNS, name, &std::pair<std::string_view, Pattern>::first
+    );
+    if (match == PATTERNS.end()) { return std::nullopt; }
+    return match->second;
+}
+
+auto Synthetic::start(
+  const Pattern pattern, const std::uint64_t bytes_per_second
+) -> std::unique_ptr<Synthetic>
+{
+    const auto master =
+      posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC | O_NONBLOCK);
+    std::array<char, 64> path{};
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0
+        || ptsname_r(master, path.data(), path.size()) != 0) {
+        std::print(
+          stderr, "[ERROR] failed to create a pty: {}\n", strerror(errno)
+        );
+        if (master >= 0) { ::close(master); }
+        return nullptr;
+    }
+
+    // Held open so the pty survives the port being closed and reopened.
+    // NOLINTNEXTLINE
+    const auto slave_fd = ::open(path.data(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    termios    tty{};
+    if (slave_fd < 0 || tcgetattr(slave_fd, &tty) != 0) {
+        std::print(
+          stderr,
+          "[ERROR] failed to open {}: {}\n",
+          path.data(),
+          strerror(errno)
+        );
+        if (slave_fd >= 0) { ::close(slave_fd); }
+        ::close(master);
+        return nullptr;
+    }
+    cfmakeraw(&tty);
+    tcsetattr(slave_fd, TCSANOW, &tty);
+
+    auto synthetic = std::unique_ptr<Synthetic>(
+      new Synthetic(master, slave_fd, path.data(), bytes_per_second)
+    );
+    synthetic->pattern = generate(pattern, PATTERN_SIZE);
+    synthetic->thread  = std::thread(&Synthetic::run, synthetic.get());
+    return synthetic;
+}
+
+Synthetic::Synthetic(
+  int           master,
+  int           slave_fd,
+  std::string   slave,
+  std::uint64_t rate
+)
+  : master(master),
+    slave_fd(slave_fd),
+    slave(std::move(slave)),
+    rate(rate),
+    stop(false),
+    generated(0),
+    overrun(0)
+{}
+
+Synthetic::~Synthetic()
+{
+    stop.store(true, std::memory_order_relaxed);
+    if (thread.joinable()) { thread.join(); }
+
+    ::close(slave_fd);
+    ::close(master);
+}
+
+void Synthetic::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    const auto    start     = Clock::now();
+    std::uint64_t accounted = 0;
+    std::size_t   offset    = 0;
+    auto          deadline  = start;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        deadline += TICK;
+        std::this_thread::sleep_until(deadline);
+
+        // Derived from the start every time, sleeping late only makes the
+        // next write bigger.
+        const auto elapsed =
+          std::chrono::duration<double>(Clock::now() - start).count();
+        const auto target =
+          static_cast<std::uint64_t>(static_cast<double>(rate) * elapsed);
+        auto due = target - std::min(target, accounted);
+
+        while (due > 0) {
+            const auto count =
+              std::min<std::uint64_t>(due, pattern.size() - offset);
+            const auto written =
+              ::write(master, pattern.data() + offset, count);
+            if (written > 0) {
+                const auto bytes = static_cast<std::uint64_t>(written);
+                generated.fetch_add(bytes, std::memory_order_relaxed);
+                offset     = (offset + bytes) % pattern.size();
+                due       -= bytes;
+                accounted += bytes;
+                continue;
+            }
+            if (written < 0 && errno == EINTR) { continue; }
+            if (written < 0 && errno != EAGAIN) { break; }
+
+            // The pty is full, give the reader until the next tick.
+            const auto left = deadline + TICK - Clock::now();
+            if (left <= Clock::duration::zero()) { break; }
+            pollfd fd{};
+            fd.fd     = master;
+            fd.events = POLLOUT;
+            const auto nanoseconds =
+              std::chrono::duration_cast<std::chrono::nanoseconds>(left);
+            const timespec timeout{
+                .tv_sec  = 0,
+                .tv_nsec = static_cast<long>(nanoseconds.count()),
+            };
+            if (ppoll(&fd, 1, &timeout, nullptr) <= 0) { break; }
+        }
+
+        overrun.fetch_add(due, std::memory_order_relaxed);
+        accounted += due;
+    }
+}
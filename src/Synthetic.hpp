@@ -0,0 +1,103 @@
+#ifndef SESAMO_SYNTHETIC_HPP
+#define SESAMO_SYNTHETIC_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// A made up device for profiling without hardware: a thread feeds a pty at
+// a fixed rate with one of a few typical kinds of traffic, and the slave
+// side is opened through Serial::open like any other tty, so everything
+// from the reactor to the UI runs exactly as it would on a real port.
+//
+// Like a UART without flow control the generator never waits for the
+// reader: whatever the pty does not take within a tick is counted as
+// overrun and skipped.
+class [[nodiscard]] Synthetic final
+{
+  public:
+    enum class Pattern : std::uint8_t
+    {
+        // 80 column lines with a running counter.
+        Lines,
+        // Uniformly random bytes, newlines included.
+        Binary,
+        // Log lines with ANSI colored levels.
+        Ansi,
+        // A counter, a timestamp and three sensor readings per line.
+        Csv,
+    };
+
+    struct Stats
+    {
+        std::uint64_t generated = 0;
+        std::uint64_t overrun   = 0;
+    };
+
+    // What the port list shows, e.g. "synthetic:lines".
+    constexpr static std::string_view PREFIX = "synthetic:";
+    constexpr static auto             PATTERNS =
+      std::to_array<std::pair<std::string_view, Pattern>>({
+        { "synthetic:lines", Pattern::Lines },
+        { "synthetic:binary", Pattern::Binary },
+        { "synthetic:ansi", Pattern::Ansi },
+        { "synthetic:csv", Pattern::Csv },
+      });
+
+    [[nodiscard]] static auto parse(std::string_view name)
+      -> std::optional<Pattern>;
+
+    // Starts generating `bytes_per_second` right away, nullptr if no pty
+    // could be set up.
+    [[nodiscard]] static auto
+      start(const Pattern pattern, const std::uint64_t bytes_per_second)
+      -> std::unique_ptr<Synthetic>;
+
+    ~Synthetic();
+
+    Synthetic(const Synthetic &)            = delete;
+    Synthetic &operator=(const Synthetic &) = delete;
+    Synthetic(Synthetic &&)                 = delete;
+    Synthetic &operator=(Synthetic &&)      = delete;
+
+    // The tty to open.
+    [[nodiscard]] const std::string &path() const noexcept { return slave; }
+
+    [[nodiscard]] Stats stats() const noexcept
+    {
+        return { .generated = generated.load(std::memory_order_relaxed),
+                 .overrun   = overrun.load(std::memory_order_relaxed) };
+    }
+
+  private:
+    Synthetic(int master, int slave_fd, std::string slave, std::uint64_t rate);
+
+    // The generator wakes this often and writes what became due since.
+    constexpr static std::chrono::milliseconds TICK{ 1 };
+
+    // Traffic is generated once up front and played in a loop, so even
+    // 100+ MB/s cost little more than the write() calls.
+    constexpr static std::size_t PATTERN_SIZE = 4 * 1024 * 1024;
+
+    int                        master   = -1;
+    int                        slave_fd = -1;
+    std::string                slave;
+    std::uint64_t              rate = 0;
+    std::vector<char>          pattern;
+    std::atomic<bool>          stop;
+    std::atomic<std::uint64_t> generated;
+    std::atomic<std::uint64_t> overrun;
+    std::thread                thread;
+
+    void run();
+};
+
+#endif // SESAMO_SYNTHETIC_HPP
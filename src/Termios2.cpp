@@ -0,0 +1,23 @@
+#include "Termios2.hpp"
+
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+
+auto set_arbitrary_baud_rate(const int fd, const std::uint32_t baud_rate)
+  -> std::optional<std::uint32_t>
+{
+    struct termios2 tty{};
+    if (ioctl(fd, TCGETS2, &tty) < 0) { return std::nullopt; }
+
+    /* same rate in both directions, given in c_ospeed/c_ispeed */
+    tty.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tty.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tty.c_ospeed = baud_rate;
+    tty.c_ispeed = baud_rate;
+
+    if (ioctl(fd, TCSETS2, &tty) < 0) { return std::nullopt; }
+
+    /* drivers round to what their divisor can do, report that back */
+    if (ioctl(fd, TCGETS2, &tty) < 0) { return std::nullopt; }
+    return tty.c_ospeed;
+}
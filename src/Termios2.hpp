@@ -0,0 +1,18 @@
+#ifndef SESAMO_TERMIOS2_HPP
+#define SESAMO_TERMIOS2_HPP
+
+#include <cstdint>
+#include <optional>
+
+// Programs an arbitrary (non Bxxx) baud rate on `fd` through the Linux
+// termios2/BOTHER interface, leaving every other setting untouched.
+// Returns the rate the driver actually settled on or nullopt (with errno
+// set) when the driver refused it.
+//
+// This lives in its own translation unit because <asm/termbits.h> and
+// glibc's <termios.h> cannot be included together.
+[[nodiscard]] auto
+  set_arbitrary_baud_rate(const int fd, const std::uint32_t baud_rate)
+  -> std::optional<std::uint32_t>;
+
+#endif // SESAMO_TERMIOS2_HPP
@@ -0,0 +1,158 @@
+#include "Timeline.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <format>
+#include <limits>
+#include <utility>
+
+namespace
+{
+
+constexpr std::int64_t NANOSECONDS_PER_SECOND = 1'000'000'000;
+constexpr std::int64_t NANOSECONDS_PER_MICRO  = 1'000;
+
+[[nodiscard]] bool fits_delta(const auto delta)
+{
+    return delta >= 0 && std::cmp_less_equal(
+                           delta, std::numeric_limits<std::uint32_t>::max()
+                         );
+}
+
+} // namespace
+
+std::string_view
+  Timeline::format_wall_clock(std::span<char> out, const std::int64_t realtime)
+{
+    const auto seconds = static_cast<time_t>(realtime / NANOSECONDS_PER_SECOND);
+    tm         local{};
+    localtime_r(&seconds, &local);
+
+    const auto result = std::format_to_n(
+      out.data(),
+      static_cast<std::ptrdiff_t>(out.size()),
+      "{:02}:{:02}:{:02}.{:06}",
+      local.tm_hour,
+      local.tm_min,
+      local.tm_sec,
+      (realtime % NANOSECONDS_PER_SECOND) / NANOSECONDS_PER_MICRO
+    );
+    return { out.data(),
+             std::min(out.size(), static_cast<std::size_t>(result.size)) };
+}
+
+std::string_view
+  Timeline::format_elapsed(std::span<char> out, const std::int64_t nanoseconds)
+{
+    const auto result = std::format_to_n(
+      out.data(),
+      static_cast<std::ptrdiff_t>(out.size()),
+      "{}.{:06}",
+      nanoseconds / NANOSECONDS_PER_SECOND,
+      (nanoseconds % NANOSECONDS_PER_SECOND) / NANOSECONDS_PER_MICRO
+    );
+    return { out.data(),
+             std::min(out.size(), static_cast<std::size_t>(result.size)) };
+}
+
+void Timeline::append(const Arrival &arrival)
+{
+    if (!blocks.empty()) {
+        const auto &block = blocks.back();
+        const auto  last  = block.end + end_deltas.back();
+        // Nothing new was stored, e.g. everything was dropped.
+        if (arrival.end <= last) { return; }
+
+        const auto end_delta  = arrival.end - block.end;
+        const auto time_delta = arrival.monotonic - block.monotonic;
+        if (end_deltas.size() - block_begin(blocks.size() - 1)
+              < CHUNKS_PER_BLOCK
+            && fits_delta(end_delta) && fits_delta(time_delta)) {
+            end_deltas.push_back(static_cast<std::uint32_t>(end_delta));
+            time_deltas.push_back(static_cast<std::uint32_t>(time_delta));
+            return;
+        }
+    } else if (arrival.end <= start) {
+        return;
+    }
+
+    blocks.push_back(Block{ .first     = discarded + end_deltas.size(),
+                            .end       = arrival.end,
+                            .monotonic = arrival.monotonic,
+                            .realtime  = arrival.realtime });
+    end_deltas.push_back(0);
+    time_deltas.push_back(0);
+}
+
+void Timeline::discard_before(const std::uint64_t offset)
+{
+    // Only whole blocks go, a partially covered one is kept around.
+    while (!blocks.empty()) {
+        const auto chunks = block_end(0);
+        const auto last   = blocks.front().end + end_deltas[chunks - 1];
+        if (last > offset) { break; }
+
+        start = last;
+        blocks.pop_front();
+        end_deltas.erase(
+          end_deltas.begin(),
+          end_deltas.begin() + static_cast<std::ptrdiff_t>(chunks)
+        );
+        time_deltas.erase(
+          time_deltas.begin(),
+          time_deltas.begin() + static_cast<std::ptrdiff_t>(chunks)
+        );
+        discarded += chunks;
+    }
+}
+
+void Timeline::clear()
+{
+    if (!blocks.empty()) { start = blocks.back().end + end_deltas.back(); }
+
+    discarded += end_deltas.size();
+    blocks.clear();
+    end_deltas.clear();
+    time_deltas.clear();
+}
+
+std::optional<Timeline::Time> Timeline::at(const std::uint64_t offset) const
+{
+    if (blocks.empty() || offset < start) { return std::nullopt; }
+    if (offset >= blocks.back().end + end_deltas.back()) {
+        return std::nullopt;
+    }
+
+    // The chunk holding `offset` is the first one ending past it.
+    auto block = std::ranges::upper_bound(blocks, offset, {}, &Block::end);
+    auto chunk = std::size_t{ 0 };
+    if (block != blocks.begin()) {
+        --block;
+        const auto index = static_cast<std::size_t>(block - blocks.begin());
+        const auto begin =
+          end_deltas.begin() + static_cast<std::ptrdiff_t>(block_begin(index));
+        const auto end =
+          end_deltas.begin() + static_cast<std::ptrdiff_t>(block_end(index));
+        const auto found = std::upper_bound(
+          begin, end, static_cast<std::uint32_t>(offset - block->end)
+        );
+        if (found == end) { ++block; }
+        chunk = static_cast<std::size_t>(found - end_deltas.begin());
+    }
+
+    const auto delta = static_cast<std::int64_t>(time_deltas[chunk]);
+    return Time{ .monotonic = block->monotonic + delta,
+                 .realtime  = block->realtime != 0 ? block->realtime + delta
+                                                   : 0 };
+}
+
+std::size_t Timeline::block_begin(const std::size_t block) const
+{
+    return blocks[block].first - discarded;
+}
+
+std::size_t Timeline::block_end(const std::size_t block) const
+{
+    return block + 1 < blocks.size() ? block_begin(block + 1)
+                                     : end_deltas.size();
+}
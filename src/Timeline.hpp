@@ -0,0 +1,97 @@
+#ifndef SESAMO_TIMELINE_HPP
+#define SESAMO_TIMELINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <deque>
+
+// Receive times of a byte stream.
+//
+// Every read the reactor does becomes one chunk: the stream offset right
+// past its last byte plus the moment the read returned. Chunks are grouped
+// in blocks that carry absolute values, inside a block a chunk is two
+// 32 bit deltas against the block anchor kept in parallel columns, so one
+// chunk costs 8 bytes no matter how long the session runs. Old chunks are
+// discarded from the front in whole blocks without moving the rest.
+class [[nodiscard]] Timeline final
+{
+  public:
+    // What the reactor thread hands over for every read, `end` is the
+    // stream offset right after the bytes it read. `realtime` is 0 unless
+    // wall clock capture is enabled on the port.
+    struct Arrival
+    {
+        std::uint64_t end       = 0;
+        std::int64_t  monotonic = 0;
+        std::int64_t  realtime  = 0;
+    };
+
+    struct Time
+    {
+        std::int64_t monotonic = 0;
+        std::int64_t realtime  = 0;
+    };
+
+    // Render a captured time into `out` (at least TIME_TEXT_SIZE bytes),
+    // "hh:mm:ss.uuuuuu" in local time and "s.uuuuuu" respectively.
+    constexpr static std::size_t TIME_TEXT_SIZE = 32;
+    [[nodiscard]] static std::string_view
+      format_wall_clock(std::span<char> out, const std::int64_t realtime);
+    [[nodiscard]] static std::string_view
+      format_elapsed(std::span<char> out, const std::int64_t nanoseconds);
+
+    void append(const Arrival &arrival);
+
+    // Forgets every chunk that ends at or before `offset`.
+    void discard_before(const std::uint64_t offset);
+    void clear();
+
+    // When the byte at stream `offset` was read, nullopt if it has not been
+    // timestamped yet or was already discarded.
+    [[nodiscard]] std::optional<Time> at(const std::uint64_t offset) const;
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return end_deltas.size();
+    }
+
+    [[nodiscard]] std::size_t memory_usage() const noexcept
+    {
+        return (blocks.size() * sizeof(Block))
+               + (end_deltas.size() * sizeof(std::uint32_t))
+               + (time_deltas.size() * sizeof(std::uint32_t));
+    }
+
+  private:
+    constexpr static std::size_t CHUNKS_PER_BLOCK = 256;
+
+    struct Block
+    {
+        // Chunks ever appended before this block, see `discarded`.
+        std::size_t   first     = 0;
+        std::uint64_t end       = 0;
+        std::int64_t  monotonic = 0;
+        // Only captured once per block, chunks derive theirs from the
+        // monotonic delta.
+        std::int64_t realtime = 0;
+    };
+
+    // Offset of the first byte of the first chunk still kept.
+    std::uint64_t start = 0;
+
+    // Chunks dropped off the front so far, `Block::first - discarded` is
+    // where a block starts in the delta columns.
+    std::size_t discarded = 0;
+
+    std::deque<Block>         blocks;
+    std::deque<std::uint32_t> end_deltas;
+    std::deque<std::uint32_t> time_deltas;
+
+    [[nodiscard]] std::size_t block_begin(const std::size_t block) const;
+    [[nodiscard]] std::size_t block_end(const std::size_t block) const;
+};
+
+#endif // SESAMO_TIMELINE_HPP
@@ -0,0 +1,232 @@
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <print>
+
+namespace
+{
+
+enum class Kind : std::uint8_t
+{
+    Complete,
+    Counter,
+};
+
+struct Event
+{
+    const char  *name;
+    std::int64_t begin;
+    // Span length for Complete, the value for Counter.
+    std::int64_t value;
+    Kind         kind;
+};
+
+struct Buffer
+{
+    std::array<Event, trace::EVENTS_PER_THREAD> events;
+    // Events ever recorded, the newest one is at (head - 1) % size.
+    std::atomic<std::uint64_t>                  head;
+    std::atomic<const char *>                   name;
+    pid_t                                       tid = 0;
+};
+
+struct Registry
+{
+    std::mutex                           mutex;
+    // Never shrinks, the events of threads that ended are still dumped.
+    std::vector<std::unique_ptr<Buffer>> buffers;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+thread_local Buffer *local = nullptr;
+
+Buffer &buffer()
+{
+    if (local == nullptr) {
+        auto owned  = std::make_unique<Buffer>();
+        owned->tid  = gettid();
+        auto &state = registry();
+
+        const std::lock_guard<std::mutex> lock(state.mutex);
+        local = state.buffers.emplace_back(std::move(owned)).get();
+    }
+    return *local;
+}
+
+void record(const Event &event)
+{
+    auto      &owner = buffer();
+    const auto head  = owner.head.load(std::memory_order_relaxed);
+    owner.events[head % trace::EVENTS_PER_THREAD] = event;
+    owner.head.store(head + 1, std::memory_order_release);
+}
+
+// Microseconds with nanosecond precision, what the format expects.
+[[nodiscard]] double to_microseconds(const std::int64_t nanoseconds)
+{
+    return static_cast<double>(nanoseconds) / 1'000.0;
+}
+
+// The events of `owner` that are still intact, oldest first.
+[[nodiscard]] std::vector<Event> snapshot(const Buffer &owner)
+{
+    constexpr auto SIZE = trace::EVENTS_PER_THREAD;
+
+    const auto end   = owner.head.load(std::memory_order_acquire);
+    const auto begin = end > SIZE ? end - SIZE : 0;
+
+    std::vector<Event> events;
+    events.reserve(static_cast<std::size_t>(end - begin));
+    for (auto i = begin; i < end; ++i) {
+        events.push_back(owner.events[i % SIZE]);
+    }
+
+    // Whatever the owner lapped while we copied may be torn, and so may
+    // the slot it is writing right now, that of event `after - SIZE`.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto after = owner.head.load(std::memory_order_relaxed);
+    if (after + 1 > SIZE + begin) {
+        const auto lapped = std::min(after + 1 - SIZE - begin, end - begin);
+        events.erase(
+          events.begin(),
+          events.begin() + static_cast<std::ptrdiff_t>(lapped)
+        );
+    }
+    return events;
+}
+
+} // namespace
+
+namespace trace
+{
+
+std::int64_t now() noexcept
+{
+    timespec time{};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (static_cast<std::int64_t>(time.tv_sec) * 1'000'000'000)
+           + time.tv_nsec;
+}
+
+void set_thread_name(const char *name)
+{
+    buffer().name.store(name, std::memory_order_release);
+}
+
+void complete(
+  const char *name, const std::int64_t begin, const std::int64_t end
+)
+{
+    record({ .name  = name,
+             .begin = begin,
+             .value = end - begin,
+             .kind  = Kind::Complete });
+}
+
+void counter(const char *name, const std::int64_t value)
+{
+    record(
+      { .name = name, .begin = now(), .value = value, .kind = Kind::Counter }
+    );
+}
+
+bool dump(const std::string_view path)
+{
+    const auto pid = getpid();
+
+    std::string json      = R"({"displayTimeUnit": "ns", "traceEvents": [)";
+    auto        out       = std::back_inserter(json);
+    auto        first     = true;
+    const auto  separator = [&first] {
+        const auto *const text = first ? "\n" : ",\n";
+        first                  = false;
+        return text;
+    };
+
+    auto &state = registry();
+    {
+        const std::lock_guard<std::mutex> lock(state.mutex);
+        for (const auto &owner : state.buffers) {
+            if (const auto *const name =
+                  owner->name.load(std::memory_order_acquire)) {
+                std::format_to(
+                  out,
+                  R"({}{{"name": "thread_name", "ph": "M", "pid": {}, )"
+                  R"("tid": {}, "args": {{"name": "{}"}}}})",
+                  separator(),
+                  pid,
+                  owner->tid,
+                  name
+                );
+            }
+
+            for (const auto &event : snapshot(*owner)) {
+                if (event.kind == Kind::Complete) {
+                    std::format_to(
+                      out,
+                      R"({}{{"name": "{}", "ph": "X", "pid": {}, "tid": {}, )"
+                      R"("ts": {:.3f}, "dur": {:.3f}}})",
+                      separator(),
+                      event.name,
+                      pid,
+                      owner->tid,
+                      to_microseconds(event.begin),
+                      to_microseconds(event.value)
+                    );
+                } else {
+                    std::format_to(
+                      out,
+                      R"({}{{"name": "{}", "ph": "C", "pid": {}, "tid": {}, )"
+                      R"("ts": {:.3f}, "args": {{"value": {}}}}})",
+                      separator(),
+                      event.name,
+                      pid,
+                      owner->tid,
+                      to_microseconds(event.begin),
+                      event.value
+                    );
+                }
+            }
+        }
+    }
+    json += "\n]}\n";
+
+    const std::string name(path);
+    // NOLINTNEXTLINE
+    auto *const file = std::fopen(name.c_str(), "w");
+    if (file == nullptr) {
+        std::print(
+          stderr, "[ERROR] failed to open {}: {}\n", name, strerror(errno)
+        );
+        return false;
+    }
+    const auto written = std::fwrite(json.data(), 1, json.size(), file);
+    // NOLINTNEXTLINE
+    if (std::fclose(file) != 0 || written != json.size()) {
+        std::print(
+          stderr, "[ERROR] failed to write {}: {}\n", name, strerror(errno)
+        );
+        return false;
+    }
+    return true;
+}
+
+} // namespace trace
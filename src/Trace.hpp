@@ -0,0 +1,75 @@
+#ifndef SESAMO_TRACE_HPP
+#define SESAMO_TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Spans of the reader, capture and UI threads in the Chrome trace event
+// format, which chrome://tracing and ui.perfetto.dev both open.
+//
+// Only compiled in when configured with -DSESAMO_TRACE=ON, otherwise the
+// SESAMO_TRACE_* macros expand to nothing. Every thread records into its
+// own ring of the last EVENTS_PER_THREAD events with plain stores and one
+// release store of its head, so recording never locks, and never allocates
+// after a thread's first event. dump() copies every ring and leaves out
+// whatever the owning thread overwrote while it was copying.
+namespace trace
+{
+
+#ifdef SESAMO_TRACE
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+constexpr std::size_t EVENTS_PER_THREAD = 64 * 1024;
+
+// CLOCK_MONOTONIC in nanoseconds, the same clock serial reads are stamped
+// with.
+[[nodiscard]] std::int64_t now() noexcept;
+
+// `name` must outlive the process, string literals are what the macros
+// pass.
+void set_thread_name(const char *name);
+void complete(const char *name, std::int64_t begin, std::int64_t end);
+void counter(const char *name, std::int64_t value);
+
+// Writes every thread's recorded events to `path` as Chrome trace JSON.
+// Recording goes on meanwhile.
+[[nodiscard]] bool dump(std::string_view path);
+
+// Records the time from construction to destruction as one span.
+class [[nodiscard]] Span final
+{
+  public:
+    explicit Span(const char *name) noexcept : name(name), begin(now()) {}
+    ~Span() { complete(name, begin, now()); }
+
+    Span(const Span &)            = delete;
+    Span &operator=(const Span &) = delete;
+    Span(Span &&)                 = delete;
+    Span &operator=(Span &&)      = delete;
+
+  private:
+    const char  *name;
+    std::int64_t begin;
+};
+
+} // namespace trace
+
+#ifdef SESAMO_TRACE
+#define SESAMO_TRACE_CONCAT_(a, b) a##b
+#define SESAMO_TRACE_CONCAT(a, b)  SESAMO_TRACE_CONCAT_(a, b)
+#define SESAMO_TRACE_SCOPE(name)                                              \
+    const ::trace::Span SESAMO_TRACE_CONCAT(sesamo_trace_span_, __LINE__)(name)
+#define SESAMO_TRACE_COUNTER(name, value)                                     \
+    ::trace::counter(name, static_cast<std::int64_t>(value))
+#define SESAMO_TRACE_THREAD(name) ::trace::set_thread_name(name)
+#else
+#define SESAMO_TRACE_SCOPE(name)          static_cast<void>(0)
+#define SESAMO_TRACE_COUNTER(name, value) static_cast<void>(0)
+#define SESAMO_TRACE_THREAD(name)         static_cast<void>(0)
+#endif
+
+#endif // SESAMO_TRACE_HPP
@@ -0,0 +1,115 @@
+#include "Headless.hpp"
+#include "Options.hpp"
+#include "Trace.hpp"
+
+#include <charconv>
+#include <span>
+#include <string_view>
+#include <print>
+
+namespace
+{
+
+constexpr std::string_view USAGE =
+  "usage: sesamo_headless [--reader=epoll|io_uring] [--baud=<rate>]\n"
+  "                       [--format=text|raw|hex] [--timestamps]\n"
+  "                       [--reconnect] [--output-dir=<dir>]\n"
+  "                       [--reader-cpu=<N>] [--reader-priority=<1-99>]\n"
+  "                       [--lock-memory]\n"
+  "                       [--backpressure=drop-newest|drop-oldest|block|"
+  "spill]\n"
+  "                       [--read-buffer=<MiB>] [--spill-dir=<dir>]\n"
+  "                       [--spill-limit=<MiB>]\n"
+  "                       [--capture=<file>]\n"
+  "                       [--trace=<file>] <tty>...\n";
+
+} // namespace
+
+auto main(int argc, char **argv) -> int
+{
+    constexpr std::string_view BAUD            = "--baud=";
+    constexpr std::string_view OUTPUT_DIR      = "--output-dir=";
+    constexpr std::string_view CAPTURE         = "--capture=";
+    constexpr std::string_view TRACE           = "--trace=";
+    constexpr std::string_view READER_CPU      = "--reader-cpu=";
+    constexpr std::string_view READER_PRIORITY = "--reader-priority=";
+
+    Headless::Options options;
+    for (const std::string_view arg :
+         std::span(argv, static_cast<std::size_t>(argc)).subspan(1)) {
+        if (arg == "--reader=epoll") {
+            options.reader_backend = Reactor::Backend::Epoll;
+        } else if (arg == "--reader=io_uring") {
+            options.reader_backend = Reactor::Backend::IoUring;
+        } else if (arg == "--format=text") {
+            options.format = Headless::Format::Text;
+        } else if (arg == "--format=raw") {
+            options.format = Headless::Format::Raw;
+        } else if (arg == "--format=hex") {
+            options.format = Headless::Format::Hex;
+        } else if (arg == "--timestamps") {
+            options.timestamps = true;
+        } else if (arg == "--reconnect") {
+            options.reconnect = true;
+        } else if (arg.starts_with(BAUD)) {
+            const auto value = arg.substr(BAUD.size());
+            const auto [end, error] = std::from_chars(
+              value.data(), value.data() + value.size(), options.baud_rate
+            );
+            if (error != std::errc{} || end != value.data() + value.size()) {
+                std::print(stderr, "{}", USAGE);
+                return 1;
+            }
+        } else if (arg.starts_with(READER_CPU)) {
+            const auto cpu =
+              cli::parse_number<unsigned>(arg.substr(READER_CPU.size()));
+            if (!cpu) {
+                std::print(stderr, "{}", USAGE);
+                return 1;
+            }
+            options.reader_tuning.cpu = *cpu;
+        } else if (arg.starts_with(READER_PRIORITY)) {
+            const auto priority =
+              cli::parse_priority(arg.substr(READER_PRIORITY.size()));
+            if (!priority) {
+                std::print(stderr, "{}", USAGE);
+                return 1;
+            }
+            options.reader_tuning.priority = *priority;
+        } else if (arg == "--lock-memory") {
+            options.reader_tuning.lock_memory = true;
+        } else if (arg.starts_with(OUTPUT_DIR)) {
+            options.output_directory = arg.substr(OUTPUT_DIR.size());
+        } else if (arg.starts_with(CAPTURE)) {
+            options.capture = arg.substr(CAPTURE.size());
+        } else if (arg.starts_with(TRACE)) {
+            if (!trace::ENABLED) {
+                std::print(
+                  stderr, "[ERROR] --trace needs a build with SESAMO_TRACE=ON\n"
+                );
+                return 1;
+            }
+            options.trace = arg.substr(TRACE.size());
+        } else if (const auto buffering =
+                     cli::parse_buffering(arg, options.buffering)) {
+            if (!*buffering) {
+                std::print(stderr, "{}", USAGE);
+                return 1;
+            }
+        } else if (arg.starts_with("-")) {
+            std::print(stderr, "{}", USAGE);
+            return 1;
+        } else {
+            options.paths.emplace_back(arg);
+        }
+    }
+
+    if (options.paths.empty()) {
+        std::print(stderr, "{}", USAGE);
+        return 1;
+    }
+
+    auto headless = Headless::spawn(options);
+    if (!headless) { return 1; }
+    return headless->run();
+}
@@ -1,8 +1,127 @@
 #include "Application.hpp"
+#include "Options.hpp"
+#include "Trace.hpp"
 
-auto main() -> int
+#include <charconv>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <print>
+
+namespace
 {
-    auto app = App::spawn();
+
+constexpr std::string_view USAGE =
+  "usage: sesamo [--reader=epoll|io_uring] [--scrollback=<MiB>] "
+  "[--max-fps=<N>]\n"
+  "              [--reader-cpu=<N>] [--reader-priority=<1-99>] "
+  "[--lock-memory]\n"
+  "              [--backpressure=drop-newest|drop-oldest|block|spill]\n"
+  "              [--read-buffer=<MiB>] [--spill-dir=<dir>] "
+  "[--spill-limit=<MiB>]\n"
+  "              [--trace=<file>]\n";
+
+constexpr std::size_t MEBIBYTE = 1024 * 1024;
+
+// Parses the `--scrollback=` value in MiB, it has to be within the budget
+// the scrollback supports.
+[[nodiscard]] auto parse_scrollback(const std::string_view value)
+  -> std::optional<std::size_t>
+{
+    std::size_t mebibytes = 0;
+    const auto [end, error] =
+      std::from_chars(value.data(), value.data() + value.size(), mebibytes);
+    if (error != std::errc{} || end != value.data() + value.size()) {
+        return std::nullopt;
+    }
+
+    if (mebibytes < Scrollback::MIN_CAPACITY / MEBIBYTE
+        || mebibytes > Scrollback::MAX_CAPACITY / MEBIBYTE) {
+        std::print(
+          stderr,
+          "[ERROR] --scrollback must be between {} and {} MiB\n",
+          Scrollback::MIN_CAPACITY / MEBIBYTE,
+          Scrollback::MAX_CAPACITY / MEBIBYTE
+        );
+        return std::nullopt;
+    }
+
+    return mebibytes * MEBIBYTE;
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int
+{
+    constexpr std::string_view SCROLLBACK      = "--scrollback=";
+    constexpr std::string_view MAX_FPS         = "--max-fps=";
+    constexpr std::string_view TRACE           = "--trace=";
+    constexpr std::string_view READER_CPU      = "--reader-cpu=";
+    constexpr std::string_view READER_PRIORITY = "--reader-priority=";
+
+    App::Options options;
+    for (const std::string_view arg :
+         std::span(argv, static_cast<std::size_t>(argc)).subspan(1)) {
+        if (arg == "--reader=epoll") {
+            options.reader_backend = Reactor::Backend::Epoll;
+        } else if (arg == "--reader=io_uring") {
+            options.reader_backend = Reactor::Backend::IoUring;
+        } else if (arg.starts_with(READER_CPU)) {
+            const auto cpu =
+              cli::parse_number<unsigned>(arg.substr(READER_CPU.size()));
+            if (!cpu) {
+                std::print(stderr, "{}", USAGE);
+                return 1;
+            }
+            options.reader_tuning.cpu = *cpu;
+        } else if (arg.starts_with(READER_PRIORITY)) {
+            const auto priority =
+              cli::parse_priority(arg.substr(READER_PRIORITY.size()));
+            if (!priority) {
+                std::print(stderr, "{}", USAGE);
+                return 1;
+            }
+            options.reader_tuning.priority = *priority;
+        } else if (arg == "--lock-memory") {
+            options.reader_tuning.lock_memory = true;
+        } else if (arg.starts_with(SCROLLBACK)) {
+            const auto capacity =
+              parse_scrollback(arg.substr(SCROLLBACK.size()));
+            if (!capacity) {
+                std::print(stderr, "{}", USAGE);
+                return 1;
+            }
+            options.scrollback_capacity = *capacity;
+        } else if (arg.starts_with(MAX_FPS)) {
+            const auto value = arg.substr(MAX_FPS.size());
+            const auto [end, error] = std::from_chars(
+              value.data(), value.data() + value.size(), options.max_fps
+            );
+            if (error != std::errc{} || end != value.data() + value.size()) {
+                std::print(stderr, "{}", USAGE);
+                return 1;
+            }
+        } else if (arg.starts_with(TRACE)) {
+            if (!trace::ENABLED) {
+                std::print(
+                  stderr, "[ERROR] --trace needs a build with SESAMO_TRACE=ON\n"
+                );
+                return 1;
+            }
+            options.trace = arg.substr(TRACE.size());
+        } else if (const auto buffering =
+                     cli::parse_buffering(arg, options.buffering)) {
+            if (!*buffering) {
+                std::print(stderr, "{}", USAGE);
+                return 1;
+            }
+        } else {
+            std::print(stderr, "{}", USAGE);
+            return 1;
+        }
+    }
+
+    auto app = App::spawn(options);
     if (!app) { return 1; }
     app->run();
 }
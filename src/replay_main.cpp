@@ -0,0 +1,114 @@
+#include "Replay.hpp"
+
+#include <charconv>
+#include <span>
+#include <string_view>
+#include <print>
+
+namespace
+{
+
+constexpr std::string_view USAGE =
+  "usage: sesamo_replay [--speed=<factor>|--max] [--from=<seconds>]\n"
+  "                     [--no-wait] <capture>\n";
+
+template <typename T>
+[[nodiscard]] bool parse(const std::string_view text, T &value)
+{
+    const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc{} && end == text.data() + text.size();
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int
+{
+    constexpr std::string_view SPEED = "--speed=";
+    constexpr std::string_view FROM  = "--from=";
+
+    Replay::Options  options;
+    auto             wait = true;
+    std::string_view path;
+    for (const std::string_view arg :
+         std::span(argv, static_cast<std::size_t>(argc)).subspan(1)) {
+        auto valid = true;
+        if (arg == "--max") {
+            options.speed = 0;
+        } else if (arg == "--no-wait") {
+            wait = false;
+        } else if (arg.starts_with(SPEED)) {
+            valid = parse(arg.substr(SPEED.size()), options.speed)
+                    && options.speed > 0;
+        } else if (arg.starts_with(FROM)) {
+            auto seconds = 0.0;
+            valid        = parse(arg.substr(FROM.size()), seconds);
+            options.from = std::chrono::nanoseconds(
+              static_cast<std::int64_t>(seconds * 1e9)
+            );
+        } else if (arg.starts_with("-") || !path.empty()) {
+            valid = false;
+        } else {
+            path = arg;
+        }
+
+        if (!valid) {
+            std::print(stderr, "{}", USAGE);
+            return 1;
+        }
+    }
+
+    if (path.empty()) {
+        std::print(stderr, "{}", USAGE);
+        return 1;
+    }
+
+    auto reader = CaptureReader::open(path);
+    if (!reader) { return 1; }
+    const auto replay = Replay::create(std::move(reader));
+    if (!replay) { return 1; }
+
+    for (const auto &pty : replay->ptys()) {
+        std::print("{} -> {}\n", pty.name, pty.path);
+    }
+    std::fflush(stdout);
+
+    if (wait && !replay->wait_for_consumers()) { return 1; }
+
+    const auto report = replay->run(options);
+    if (!report) { return 1; }
+
+    const auto rate = [&report](const std::chrono::nanoseconds duration) {
+        const auto seconds = std::chrono::duration<double>(duration).count();
+        return seconds > 0 ? static_cast<double>(report->bytes) / seconds
+                           : 0.0;
+    };
+    const auto micros = [](const std::chrono::nanoseconds duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    };
+
+    std::print(
+      "replayed {} bytes in {} chunks ({} skipped) in {:.3f} s\n",
+      report->bytes,
+      report->chunks,
+      report->skipped,
+      std::chrono::duration<double>(report->elapsed).count()
+    );
+    if (options.speed > 0) {
+        std::print(
+          "rate: {:.0f} B/s achieved, {:.0f} B/s target\n"
+          "timing error: p50 {:.1f} us, p99 {:.1f} us, p99.9 {:.1f} us, "
+          "max {:.1f} us\n",
+          rate(report->elapsed),
+          rate(report->scheduled),
+          micros(report->error_p50),
+          micros(report->error_p99),
+          micros(report->error_p999),
+          micros(report->error_max)
+        );
+    } else {
+        std::print("rate: {:.0f} B/s\n", rate(report->elapsed));
+    }
+
+    return 0;
+}